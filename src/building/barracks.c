@@ -75,14 +75,13 @@ static int get_closest_military_academy(const building *fort)
 {
     int min_building_id = 0;
     int min_distance = INFINITE;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_MILITARY_ACADEMY &&
+    for (building *b = building_first_of_type(BUILDING_MILITARY_ACADEMY); b; b = building_next_of_type(b)) {
+        if (b->state == BUILDING_STATE_IN_USE &&
             b->num_workers >= model_get_building(BUILDING_MILITARY_ACADEMY)->laborers) {
             int dist = calc_maximum_distance(fort->x, fort->y, b->x, b->y);
             if (dist < min_distance) {
                 min_distance = dist;
-                min_building_id = i;
+                min_building_id = b->id;
             }
         }
     }
@@ -128,9 +127,8 @@ int building_barracks_create_tower_sentry(building *barracks, int x, int y)
         return 0;
     }
     building *tower = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_TOWER && b->num_workers > 0 &&
+    for (building *b = building_first_of_type(BUILDING_TOWER); b; b = building_next_of_type(b)) {
+        if (b->state == BUILDING_STATE_IN_USE && b->num_workers > 0 &&
             !b->figure_id && b->road_network_id == barracks->road_network_id) {
             tower = b;
             break;
@@ -6,6 +6,7 @@
 #include "city/buildings.h"
 #include "city/population.h"
 #include "city/warning.h"
+#include "core/config.h"
 #include "figure/formation_legion.h"
 #include "game/resource.h"
 #include "game/undo.h"
@@ -18,9 +19,23 @@
 #include "map/terrain.h"
 #include "map/tiles.h"
 
+#include <stdlib.h>
 #include <string.h>
 
-static building all_buildings[MAX_BUILDINGS];
+#define BUILDING_BLOCK_SHIFT 10
+#define BUILDING_BLOCK_SIZE (1 << BUILDING_BLOCK_SHIFT)
+#define BUILDING_BLOCK_MASK (BUILDING_BLOCK_SIZE - 1)
+#define MAX_BUILDING_BLOCKS ((MAX_BUILDINGS + BUILDING_BLOCK_SIZE - 1) / BUILDING_BLOCK_SIZE)
+#define ORIGINAL_BUILDING_BLOCKS ((ORIGINAL_MAX_BUILDINGS + BUILDING_BLOCK_SIZE - 1) / BUILDING_BLOCK_SIZE)
+
+static building original_buildings[ORIGINAL_BUILDING_BLOCKS][BUILDING_BLOCK_SIZE];
+
+// Buildings are allocated in blocks so that pointers to them stay valid when the array grows
+static struct {
+    building *blocks[MAX_BUILDING_BLOCKS];
+    int num_blocks;
+    int size;
+} all_buildings = {{original_buildings[0], original_buildings[1]}, ORIGINAL_BUILDING_BLOCKS, ORIGINAL_MAX_BUILDINGS};
 
 static struct {
     int highest_id_in_use;
@@ -30,9 +45,70 @@ static struct {
     int unfixable_houses;
 } extra = {0, 0, 0, 0};
 
+static struct {
+    int first[BUILDING_TYPE_MAX];
+    int next[MAX_BUILDINGS];
+    int prev[MAX_BUILDINGS];
+    short type[MAX_BUILDINGS];
+} type_index;
+
 building *building_get(int id)
 {
-    return &all_buildings[id];
+    return &all_buildings.blocks[id >> BUILDING_BLOCK_SHIFT][id & BUILDING_BLOCK_MASK];
+}
+
+int building_count(void)
+{
+    return all_buildings.size;
+}
+
+static int ensure_capacity(int size)
+{
+    int blocks_needed = (size + BUILDING_BLOCK_SIZE - 1) / BUILDING_BLOCK_SIZE;
+    if (blocks_needed > MAX_BUILDING_BLOCKS) {
+        return 0;
+    }
+    while (all_buildings.num_blocks < blocks_needed) {
+        building *block = (building *) calloc(BUILDING_BLOCK_SIZE, sizeof(building));
+        if (!block) {
+            return 0;
+        }
+        int first_id = all_buildings.num_blocks * BUILDING_BLOCK_SIZE;
+        for (int i = 0; i < BUILDING_BLOCK_SIZE; i++) {
+            block[i].id = first_id + i;
+        }
+        all_buildings.blocks[all_buildings.num_blocks++] = block;
+    }
+    return 1;
+}
+
+int building_reserve_slots(int count)
+{
+    return ensure_capacity(count);
+}
+
+static void clear_buildings(int size)
+{
+    if (!ensure_capacity(size)) {
+        size = all_buildings.num_blocks * BUILDING_BLOCK_SIZE;
+    }
+    for (int b = 0; b < all_buildings.num_blocks; b++) {
+        building *block = all_buildings.blocks[b];
+        memset(block, 0, BUILDING_BLOCK_SIZE * sizeof(building));
+        for (int i = 0; i < BUILDING_BLOCK_SIZE; i++) {
+            block[i].id = b * BUILDING_BLOCK_SIZE + i;
+        }
+    }
+    all_buildings.size = size;
+}
+
+static building *add_building_slot(void)
+{
+    if (!config_get(CONFIG_GP_EXTEND_ENTITY_LIMITS) || all_buildings.size >= MAX_BUILDINGS ||
+        !ensure_capacity(all_buildings.size + 1)) {
+        return 0;
+    }
+    return building_get(all_buildings.size++);
 }
 
 building *building_main(building *b)
@@ -41,28 +117,117 @@ building *building_main(building *b)
         if (b->prev_part_building_id <= 0) {
             return b;
         }
-        b = &all_buildings[b->prev_part_building_id];
+        b = building_get(b->prev_part_building_id);
     }
-    return &all_buildings[0];
+    return building_get(0);
 }
 
 building *building_next(building *b)
 {
-    return &all_buildings[b->next_part_building_id];
+    return building_get(b->next_part_building_id);
+}
+
+static void type_index_remove(int id)
+{
+    int type = type_index.type[id];
+    if (type == BUILDING_NONE) {
+        return;
+    }
+    int prev = type_index.prev[id];
+    int next = type_index.next[id];
+    if (prev) {
+        type_index.next[prev] = next;
+    } else {
+        type_index.first[type] = next;
+    }
+    if (next) {
+        type_index.prev[next] = prev;
+    }
+    type_index.type[id] = BUILDING_NONE;
+}
+
+static void type_index_add(int id, int type)
+{
+    if (type <= BUILDING_NONE || type >= BUILDING_TYPE_MAX) {
+        return;
+    }
+    // keep the list sorted on ID so iterating it visits buildings in the same order as a full scan
+    int prev = 0;
+    for (int i = id - 1; i > 0; i--) {
+        if (type_index.type[i] == type) {
+            prev = i;
+            break;
+        }
+    }
+    int next = prev ? type_index.next[prev] : type_index.first[type];
+    type_index.prev[id] = prev;
+    type_index.next[id] = next;
+    if (prev) {
+        type_index.next[prev] = id;
+    } else {
+        type_index.first[type] = id;
+    }
+    if (next) {
+        type_index.prev[next] = id;
+    }
+    type_index.type[id] = type;
+}
+
+void building_update_type_index(building *b)
+{
+    int id = b->id;
+    if (id <= 0 || id >= MAX_BUILDINGS || type_index.type[id] == b->type) {
+        return;
+    }
+    type_index_remove(id);
+    type_index_add(id, b->type);
+}
+
+static void rebuild_type_index(void)
+{
+    memset(&type_index, 0, sizeof(type_index));
+    for (int i = all_buildings.size - 1; i > 0; i--) {
+        int type = building_get(i)->type;
+        if (type > BUILDING_NONE && type < BUILDING_TYPE_MAX) {
+            int next = type_index.first[type];
+            type_index.next[i] = next;
+            if (next) {
+                type_index.prev[next] = i;
+            }
+            type_index.first[type] = i;
+            type_index.type[i] = type;
+        }
+    }
+}
+
+building *building_first_of_type(building_type type)
+{
+    int id = type_index.first[type];
+    return id ? building_get(id) : 0;
+}
+
+building *building_next_of_type(const building *b)
+{
+    int id = type_index.next[b->id];
+    return id ? building_get(id) : 0;
 }
 
 building *building_create(building_type type, int x, int y)
 {
     building *b = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        if (all_buildings[i].state == BUILDING_STATE_UNUSED && !game_undo_contains_building(i)) {
-            b = &all_buildings[i];
+    for (int i = 1; i < all_buildings.size; i++) {
+        building *slot = building_get(i);
+        if (slot->state == BUILDING_STATE_UNUSED && !game_undo_contains_building(i)) {
+            b = slot;
             break;
         }
     }
+    if (!b) {
+        b = add_building_slot();
+    }
     if (!b) {
         city_warning_show(WARNING_DATA_LIMIT_REACHED);
-        return &all_buildings[0];
+        return building_get(0);
     }
 
     const building_properties *props = building_properties_for_type(type);
@@ -73,6 +238,7 @@ building *building_create(building_type type, int x, int y)
     b->faction_id = 1;
     b->unknown_value = city_buildings_unknown_value();
     b->type = type;
+    building_update_type_index(b);
     b->size = props->size;
     b->created_sequence = extra.created_sequence++;
     b->sentiment.house_happiness = 50;
@@ -175,6 +341,7 @@ static void building_delete(building *b)
     int id = b->id;
     memset(b, 0, sizeof(building));
     b->id = id;
+    building_update_type_index(b);
 }
 
 void building_clear_related_data(building *b)
@@ -209,8 +376,8 @@ void building_update_state(void)
     int wall_recalc = 0;
     int road_recalc = 0;
     int aqueduct_recalc = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = &all_buildings[i];
+    for (int i = 1; i < all_buildings.size; i++) {
+        building *b = building_get(i);
         if (b->state == BUILDING_STATE_CREATED) {
             b->state = BUILDING_STATE_IN_USE;
         }
@@ -253,8 +420,8 @@ void building_update_state(void)
 
 void building_update_desirability(void)
 {
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = &all_buildings[i];
+    for (int i = 1; i < all_buildings.size; i++) {
+        building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
@@ -293,8 +460,8 @@ int building_get_highest_id(void)
 void building_update_highest_id(void)
 {
     extra.highest_id_in_use = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        if (all_buildings[i].state != BUILDING_STATE_UNUSED) {
+    for (int i = 1; i < all_buildings.size; i++) {
+        if (building_get(i)->state != BUILDING_STATE_UNUSED) {
             extra.highest_id_in_use = i;
         }
     }
@@ -313,22 +480,20 @@ void building_totals_add_corrupted_house(int unfixable)
 
 void building_clear_all(void)
 {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        memset(&all_buildings[i], 0, sizeof(building));
-        all_buildings[i].id = i;
-    }
+    clear_buildings(ORIGINAL_MAX_BUILDINGS);
     extra.highest_id_in_use = 0;
     extra.highest_id_ever = 0;
     extra.created_sequence = 0;
     extra.incorrect_houses = 0;
     extra.unfixable_houses = 0;
+    rebuild_type_index();
 }
 
 void building_save_state(buffer *buf, buffer *highest_id, buffer *highest_id_ever,
                          buffer *sequence, buffer *corrupt_houses)
 {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        building_state_save_to_buffer(buf, &all_buildings[i]);
+    for (int i = 0; i < all_buildings.size; i++) {
+        building_state_save_to_buffer(buf, building_get(i));
     }
     buffer_write_i32(highest_id, extra.highest_id_in_use);
     buffer_write_i32(highest_id_ever, extra.highest_id_ever);
@@ -342,9 +507,16 @@ void building_save_state(buffer *buf, buffer *highest_id, buffer *highest_id_eve
 void building_load_state(buffer *buf, buffer *highest_id, buffer *highest_id_ever,
                          buffer *sequence, buffer *corrupt_houses)
 {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        building_state_load_from_buffer(buf, &all_buildings[i]);
-        all_buildings[i].id = i;
+    int size = buf->size / BUILDING_STATE_SIZE;
+    if (size < ORIGINAL_MAX_BUILDINGS) {
+        size = ORIGINAL_MAX_BUILDINGS;
+    } else if (size > MAX_BUILDINGS) {
+        size = MAX_BUILDINGS;
+    }
+    clear_buildings(size);
+    for (int i = 0; i < all_buildings.size; i++) {
+        building_state_load_from_buffer(buf, building_get(i));
+        building_get(i)->id = i;
     }
     extra.highest_id_in_use = buffer_read_i32(highest_id);
     extra.highest_id_ever = buffer_read_i32(highest_id_ever);
@@ -353,4 +525,5 @@ void building_load_state(buffer *buf, buffer *highest_id, buffer *highest_id_eve
 
     extra.incorrect_houses = buffer_read_i32(corrupt_houses);
     extra.unfixable_houses = buffer_read_i32(corrupt_houses);
+    rebuild_type_index();
 }
@@ -4,7 +4,15 @@
 #include "building/type.h"
 #include "core/buffer.h"
 
-#define MAX_BUILDINGS 2000
+/**
+ * Number of building slots in the original game, a city always has at least this many slots
+ */
+#define ORIGINAL_MAX_BUILDINGS 2000
+
+/**
+ * Maximum number of building slots a city can grow to
+ */
+#define MAX_BUILDINGS 30000
 
 typedef struct {
     int id;
@@ -141,12 +149,46 @@ typedef struct {
 
 building *building_get(int id);
 
+/**
+ * Returns the number of building slots, building IDs range from 1 to building_count() - 1
+ * @return Number of building slots
+ */
+int building_count(void);
+
+/**
+ * Allocates memory for the given number of building slots, without adding them
+ * @param count Number of building slots
+ * @return Boolean true if the memory is available, false otherwise
+ */
+int building_reserve_slots(int count);
+
 building *building_main(building *b);
 
 building *building_next(building *b);
 
 building *building_create(building_type type, int x, int y);
 
+/**
+ * Updates the per-type building lists after the type of a building has been changed directly
+ * @param b Building whose type was changed
+ */
+void building_update_type_index(building *b);
+
+/**
+ * Returns the building with the lowest ID of the given type.
+ * Buildings of every state are returned, callers should check the state themselves.
+ * @param type Building type
+ * @return Building or 0 if there is no building of this type
+ */
+building *building_first_of_type(building_type type);
+
+/**
+ * Returns the building with the next higher ID of the same type
+ * @param b Building returned by building_first_of_type() or building_next_of_type()
+ * @return Building or 0 if there are no more buildings of this type
+ */
+building *building_next_of_type(const building *b);
+
 void building_clear_related_data(building *b);
 
 void building_update_state(void);
@@ -4,6 +4,11 @@
 #include "building/building.h"
 #include "core/buffer.h"
 
+/**
+ * Number of bytes a building takes up in a saved game
+ */
+#define BUILDING_STATE_SIZE 128
+
 void building_state_save_to_buffer(buffer *buf, const building *b);
 
 void building_state_load_from_buffer(buffer *buf, building *b);
@@ -48,6 +48,7 @@ static void destroy_on_fire(building *b, int plagued)
         b->state = BUILDING_STATE_DELETED_BY_GAME;
     } else {
         b->type = BUILDING_BURNING_RUIN;
+        building_update_type_index(b);
         b->figure_id4 = 0;
         b->tax_income_or_storage = 0;
         b->fire_duration = (b->house_figure_generation_delay & 7) + 1;
@@ -162,7 +163,7 @@ void building_destroy_by_rioter(building *b)
 
 int building_destroy_first_of_type(building_type type)
 {
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->type == type) {
             int grid_offset = b->grid_offset;
@@ -181,7 +182,7 @@ void building_destroy_last_placed(void)
 {
     int highest_sequence = 0;
     building *last_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_CREATED || b->state == BUILDING_STATE_IN_USE) {
             if (b->created_sequence > highest_sequence) {
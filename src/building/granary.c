@@ -3,6 +3,7 @@
 #include "building/destruction.h"
 #include "building/model.h"
 #include "building/storage.h"
+#include "building/storage_network.h"
 #include "building/warehouse.h"
 #include "city/message.h"
 #include "city/resource.h"
@@ -177,9 +178,8 @@ void building_granaries_calculate_stocks(void)
     non_getting_granaries.total_storage_fruit = 0;
     non_getting_granaries.total_storage_meat = 0;
 
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
+    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (!b->has_road_access || b->distance_from_entry <= 0) {
@@ -204,7 +204,7 @@ void building_granaries_calculate_stocks(void)
             non_getting_granaries.total_storage_meat += b->data.granary.resource_stored[RESOURCE_MEAT];
         }
         if (total_non_getting > ONE_LOAD) {
-            non_getting_granaries.building_ids[non_getting_granaries.num_items] = i;
+            non_getting_granaries.building_ids[non_getting_granaries.num_items] = b->id;
             if (non_getting_granaries.num_items < MAX_GRANARIES - 2) {
                 non_getting_granaries.num_items++;
             }
@@ -226,7 +226,10 @@ int building_granary_for_storing(int x, int y, int resource, int distance_from_e
     }
     int min_dist = INFINITE;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    int num_granaries;
+    const int *granaries = building_storage_network_granaries(road_network_id, &num_granaries);
+    for (int n = 0; n < num_granaries; n++) {
+        int i = granaries[n];
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
             continue;
@@ -275,7 +278,10 @@ int building_getting_granary_for_storing(int x, int y, int resource, int distanc
     }
     int min_dist = INFINITE;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    int num_granaries;
+    const int *granaries = building_storage_network_granaries(road_network_id, &num_granaries);
+    for (int n = 0; n < num_granaries; n++) {
+        int i = granaries[n];
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
             continue;
@@ -374,9 +380,8 @@ void building_granary_bless(void)
 {
     int min_stored = INFINITE;
     building *min_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
+    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         int total_stored = 0;
@@ -408,7 +413,7 @@ void building_granary_warehouse_curse(int big)
 {
     int max_stored = 0;
     building *max_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
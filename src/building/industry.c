@@ -36,7 +36,7 @@ static void update_farm_image(const building *b)
 
 void building_industry_update_production(void)
 {
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !b->output_resource_id) {
             continue;
@@ -78,7 +78,7 @@ void building_industry_update_wheat_production(void)
     if (scenario_property_climate() == CLIMATE_NORTHERN) {
         return;
     }
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !b->output_resource_id) {
             continue;
@@ -122,7 +122,7 @@ void building_industry_start_new_production(building *b)
 
 void building_bless_farms(void)
 {
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->output_resource_id && building_is_farm(b->type)) {
             b->data.industry.progress = MAX_PROGRESS_RAW;
@@ -135,7 +135,7 @@ void building_bless_farms(void)
 
 void building_curse_farms(int big_curse)
 {
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->output_resource_id && building_is_farm(b->type)) {
             b->data.industry.progress = 0;
@@ -165,7 +165,7 @@ int building_get_workshop_for_raw_material_with_room(
     }
     int min_dist = INFINITE;
     building *min_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !building_is_workshop(b->type)) {
             continue;
@@ -203,7 +203,7 @@ int building_get_workshop_for_raw_material(
     }
     int min_dist = INFINITE;
     building *min_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !building_is_workshop(b->type)) {
             continue;
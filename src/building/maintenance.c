@@ -3,6 +3,7 @@
 #include "building/building.h"
 #include "building/destruction.h"
 #include "building/list.h"
+#include "building/storage_network.h"
 #include "city/buildings.h"
 #include "city/map.h"
 #include "city/message.h"
@@ -39,9 +40,8 @@ void building_maintenance_update_burning_ruins(void)
     scenario_climate climate = scenario_property_climate();
     int recalculate_terrain = 0;
     building_list_burning_clear();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_BURNING_RUIN) {
+    for (building *b = building_first_of_type(BUILDING_BURNING_RUIN); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (b->fire_duration < 0) {
@@ -51,14 +51,14 @@ void building_maintenance_update_burning_ruins(void)
         if (b->fire_duration > 32) {
             game_undo_disable();
             b->state = BUILDING_STATE_RUBBLE;
-            map_building_tiles_set_rubble(i, b->x, b->y, b->size);
+            map_building_tiles_set_rubble(b->id, b->x, b->y, b->size);
             recalculate_terrain = 1;
             continue;
         }
         if (b->ruin_has_plague) {
             continue;
         }
-        building_list_burning_add(i);
+        building_list_burning_add(b->id);
         if (climate == CLIMATE_DESERT) {
             if (b->fire_duration & 3) { // check spread every 4 ticks
                 continue;
@@ -225,7 +225,7 @@ void building_maintenance_check_rome_access(void)
     const map_tile *entry_point = city_map_entry_point();
     map_routing_calculate_distances(entry_point->x, entry_point->y);
     int problem_grid_offset = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
@@ -305,6 +305,7 @@ void building_maintenance_check_rome_access(void)
             }
         }
     }
+    building_storage_network_update();
     const map_tile *exit_point = city_map_exit_point();
     if (!map_routing_distance(exit_point->grid_offset)) {
         // no route through city
@@ -0,0 +1,64 @@
+#include "storage_network.h"
+
+#include "building/building.h"
+
+#include <string.h>
+
+#define MAX_NETWORKS 256
+
+typedef struct {
+    int start[MAX_NETWORKS + 1];
+    int items[MAX_BUILDINGS];
+} network_table;
+
+static struct {
+    network_table warehouse_spaces;
+    network_table granaries;
+} data;
+
+static void fill_table(network_table *table, building_type type)
+{
+    memset(table->start, 0, sizeof(table->start));
+    for (building *b = building_first_of_type(type); b; b = building_next_of_type(b)) {
+        if (b->distance_from_entry > 0) {
+            table->start[b->road_network_id + 1]++;
+        }
+    }
+    for (int n = 1; n <= MAX_NETWORKS; n++) {
+        table->start[n] += table->start[n - 1];
+    }
+    int next[MAX_NETWORKS];
+    memcpy(next, table->start, sizeof(next));
+    for (building *b = building_first_of_type(type); b; b = building_next_of_type(b)) {
+        if (b->distance_from_entry > 0) {
+            table->items[next[b->road_network_id]++] = b->id;
+        }
+    }
+}
+
+void building_storage_network_update(void)
+{
+    fill_table(&data.warehouse_spaces, BUILDING_WAREHOUSE_SPACE);
+    fill_table(&data.granaries, BUILDING_GRANARY);
+}
+
+static const int *get_items(const network_table *table, int road_network_id, int *count)
+{
+    if (road_network_id < 0 || road_network_id >= MAX_NETWORKS) {
+        *count = 0;
+        return table->items;
+    }
+    int start = table->start[road_network_id];
+    *count = table->start[road_network_id + 1] - start;
+    return &table->items[start];
+}
+
+const int *building_storage_network_warehouse_spaces(int road_network_id, int *count)
+{
+    return get_items(&data.warehouse_spaces, road_network_id, count);
+}
+
+const int *building_storage_network_granaries(int road_network_id, int *count)
+{
+    return get_items(&data.granaries, road_network_id, count);
+}
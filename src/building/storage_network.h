@@ -0,0 +1,31 @@
+#ifndef BUILDING_STORAGE_NETWORK_H
+#define BUILDING_STORAGE_NETWORK_H
+
+/**
+ * @file
+ * Per road network tables of storage buildings that are reachable from the city entry
+ */
+
+/**
+ * Rebuilds the tables from the current road network ids and entry distances of the buildings.
+ * Must be called whenever building_maintenance_check_rome_access() has updated them.
+ */
+void building_storage_network_update(void);
+
+/**
+ * Returns the warehouse spaces that were connected to the given road network at the last update
+ * @param road_network_id Road network ID
+ * @param count Out: number of items
+ * @return List of building IDs, in ascending order
+ */
+const int *building_storage_network_warehouse_spaces(int road_network_id, int *count);
+
+/**
+ * Returns the granaries that were connected to the given road network at the last update
+ * @param road_network_id Road network ID
+ * @param count Out: number of items
+ * @return List of building IDs, in ascending order
+ */
+const int *building_storage_network_granaries(int road_network_id, int *count);
+
+#endif // BUILDING_STORAGE_NETWORK_H
@@ -3,6 +3,7 @@
 #include "building/count.h"
 #include "building/model.h"
 #include "building/storage.h"
+#include "building/storage_network.h"
 #include "city/buildings.h"
 #include "city/finance.h"
 #include "city/military.h"
@@ -199,9 +200,9 @@ void building_warehouse_space_remove_export(building *space, int resource)
 void building_warehouses_add_resource(int resource, int amount)
 {
     int building_id = city_resource_last_used_warehouse();
-    for (int i = 1; i < MAX_BUILDINGS && amount > 0; i++) {
+    for (int i = 1; i < building_count() && amount > 0; i++) {
         building_id++;
-        if (building_id >= MAX_BUILDINGS) {
+        if (building_id >= building_count()) {
             building_id = 1;
         }
         building *b = building_get(building_id);
@@ -219,9 +220,9 @@ int building_warehouses_remove_resource(int resource, int amount)
     int amount_left = amount;
     int building_id = city_resource_last_used_warehouse();
     // first go for non-getting warehouses
-    for (int i = 1; i < MAX_BUILDINGS && amount_left > 0; i++) {
+    for (int i = 1; i < building_count() && amount_left > 0; i++) {
         building_id++;
-        if (building_id >= MAX_BUILDINGS) {
+        if (building_id >= building_count()) {
             building_id = 1;
         }
         building *b = building_get(building_id);
@@ -233,9 +234,9 @@ int building_warehouses_remove_resource(int resource, int amount)
         }
     }
     // if that doesn't work, take it anyway
-    for (int i = 1; i < MAX_BUILDINGS && amount_left > 0; i++) {
+    for (int i = 1; i < building_count() && amount_left > 0; i++) {
         building_id++;
-        if (building_id >= MAX_BUILDINGS) {
+        if (building_id >= building_count()) {
             building_id = 1;
         }
         building *b = building_get(building_id);
@@ -253,7 +254,10 @@ int building_warehouse_for_storing(int src_building_id, int x, int y, int resour
 {
     int min_dist = 10000;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    int num_spaces;
+    const int *spaces = building_storage_network_warehouse_spaces(road_network_id, &num_spaces);
+    for (int n = 0; n < num_spaces; n++) {
+        int i = spaces[n];
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE_SPACE) {
             continue;
@@ -302,12 +306,11 @@ int building_warehouse_for_getting(building *src, int resource, map_point *dst)
 {
     int min_dist = 10000;
     building *min_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE) {
+    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
-        if (i == src->id) {
+        if (b->id == src->id) {
             continue;
         }
         int loads_stored = 0;
@@ -348,9 +351,8 @@ static int determine_granary_accept_foods(int resources[RESOURCE_MAX_FOOD])
         resources[i] = 0;
     }
     int can_accept = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY || !b->has_road_access) {
+    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access) {
             continue;
         }
         int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
@@ -378,9 +380,8 @@ static int determine_granary_get_foods(int resources[RESOURCE_MAX_FOOD])
         resources[i] = 0;
     }
     int can_get = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY || !b->has_road_access) {
+    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access) {
             continue;
         }
         int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
@@ -1025,6 +1025,15 @@ static void load_entry_exit(buffer *entry_exit_xy, buffer *entry_exit_grid_offse
     city_data.map.exit_flag.grid_offset = buffer_read_i32(entry_exit_grid_offset);
 }
 
+void city_data_load_basic_info(buffer *main, int *population, int *treasury)
+{
+    // same layout as save_main_data
+    buffer_skip(main, 18068 + 8 + 4);
+    *treasury = buffer_read_i32(main);
+    buffer_skip(main, 20);
+    *population = buffer_read_i32(main);
+}
+
 void city_data_save_state(buffer *main, buffer *faction, buffer *faction_unknown, buffer *graph_order,
                           buffer *entry_exit_xy, buffer *entry_exit_grid_offset)
 {
@@ -450,7 +450,7 @@ static void calculate_max_prosperity(void)
 {
     int points = 0;
     int houses = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state && b->house_size) {
             points += model_get_house(b->subtype.house_level)->prosperity;
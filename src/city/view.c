@@ -4,8 +4,11 @@
 #include "graphics/menu.h"
 #include "map/grid.h"
 #include "map/image.h"
+#include "widget/city_with_overlay.h"
 #include "widget/minimap.h"
 
+#include <stdint.h>
+
 #define TILE_WIDTH_PIXELS 60
 #define TILE_HEIGHT_PIXELS 30
 #define HALF_TILE_WIDTH_PIXELS 30
@@ -14,6 +17,37 @@
 static const int X_DIRECTION_FOR_ORIENTATION[] = {1,  1, -1, -1};
 static const int Y_DIRECTION_FOR_ORIENTATION[] = {1, -1, -1,  1};
 
+typedef struct {
+    int x_view_start;
+    int x_view_skip;
+    int x_view_step;
+    int y_view_start;
+    int y_view_skip;
+    int y_view_step;
+} lookup_layout;
+
+// x_view is in half tiles: the lookup uses x_view / 2
+static const lookup_layout LOOKUP_LAYOUT_FOR_ORIENTATION[] = {
+    {VIEW_X_MAX - 1, -1, 1, 1, 1, 1}, // DIR_0_TOP
+    {3, 1, 1, VIEW_X_MAX - 3, 1, -1}, // DIR_2_RIGHT
+    {VIEW_X_MAX - 1, 1, -1, VIEW_Y_MAX - 2, -1, -1}, // DIR_4_BOTTOM
+    {VIEW_Y_MAX, -1, -1, VIEW_X_MAX - 3, -1, 1} // DIR_6_LEFT
+};
+
+typedef struct {
+    int16_t grid_offset[VIEW_Y_MAX][VIEW_X_MAX];
+    struct {
+        int16_t first;
+        int16_t end;
+    } valid_tiles[VIEW_Y_MAX];
+} view_lookup;
+
+typedef struct {
+    int x_view_start;
+    int x_view_end;
+    int x_graphic;
+} view_row;
+
 static struct {
     int screen_width;
     int screen_height;
@@ -37,7 +71,9 @@ static struct {
     } selected_tile;
 } data;
 
-static int view_to_grid_offset_lookup[VIEW_X_MAX][VIEW_Y_MAX];
+// all orientations are calculated when the map is loaded, so rotating only switches tables
+static view_lookup lookups[4];
+static const view_lookup *lookup = &lookups[0];
 
 static void check_camera_boundaries(void)
 {
@@ -62,78 +98,60 @@ static void check_camera_boundaries(void)
     data.camera.tile.y &= ~1;
 }
 
-static void reset_lookup(void)
+static void calculate_lookup(view_lookup *l, const lookup_layout *layout)
 {
     for (int y = 0; y < VIEW_Y_MAX; y++) {
         for (int x = 0; x < VIEW_X_MAX; x++) {
-            view_to_grid_offset_lookup[x][y] = -1;
+            l->grid_offset[y][x] = -1;
         }
     }
-}
-
-static void calculate_lookup(void)
-{
-    reset_lookup();
-    int y_view_start;
-    int y_view_skip;
-    int y_view_step;
-    int x_view_start;
-    int x_view_skip;
-    int x_view_step;
-    switch (data.orientation) {
-        default:
-        case DIR_0_TOP:
-            x_view_start = VIEW_X_MAX - 1;
-            x_view_skip = -1;
-            x_view_step = 1;
-            y_view_start = 1;
-            y_view_skip = 1;
-            y_view_step = 1;
-            break;
-        case DIR_2_RIGHT:
-            x_view_start = 3;
-            x_view_skip = 1;
-            x_view_step = 1;
-            y_view_start = VIEW_X_MAX - 3;
-            y_view_skip = 1;
-            y_view_step = -1;
-            break;
-        case DIR_4_BOTTOM:
-            x_view_start = VIEW_X_MAX - 1;
-            x_view_skip = 1;
-            x_view_step = -1;
-            y_view_start = VIEW_Y_MAX - 2;
-            y_view_skip = -1;
-            y_view_step = -1;
-            break;
-        case DIR_6_LEFT:
-            x_view_start = VIEW_Y_MAX;
-            x_view_skip = -1;
-            x_view_step = -1;
-            y_view_start = VIEW_X_MAX - 3;
-            y_view_skip = -1;
-            y_view_step = 1;
-            break;
-    }
-
+    int x_view_start = layout->x_view_start;
+    int y_view_start = layout->y_view_start;
     for (int y = 0; y < GRID_SIZE; y++) {
         int x_view = x_view_start;
         int y_view = y_view_start;
         for (int x = 0; x < GRID_SIZE; x++) {
             int grid_offset = x + GRID_SIZE * y;
             if (map_image_at(grid_offset) < 6) {
-                view_to_grid_offset_lookup[x_view/2][y_view] = -1;
+                l->grid_offset[y_view][x_view / 2] = -1;
             } else {
-                view_to_grid_offset_lookup[x_view/2][y_view] = grid_offset;
+                l->grid_offset[y_view][x_view / 2] = (int16_t) grid_offset;
+            }
+            x_view += layout->x_view_step;
+            y_view += layout->y_view_step;
+        }
+        x_view_start += layout->x_view_skip;
+        y_view_start += layout->y_view_skip;
+    }
+    for (int y = 0; y < VIEW_Y_MAX; y++) {
+        int first = VIEW_X_MAX;
+        int end = 0;
+        for (int x = 0; x < VIEW_X_MAX; x++) {
+            if (l->grid_offset[y][x] >= 0) {
+                if (x < first) {
+                    first = x;
+                }
+                end = x + 1;
             }
-            x_view += x_view_step;
-            y_view += y_view_step;
         }
-        x_view_start += x_view_skip;
-        y_view_start += y_view_skip;
+        l->valid_tiles[y].first = (int16_t) first;
+        l->valid_tiles[y].end = (int16_t) end;
     }
 }
 
+static void select_lookup(void)
+{
+    lookup = &lookups[data.orientation / 2];
+}
+
+static void calculate_lookups(void)
+{
+    for (int i = 0; i < 4; i++) {
+        calculate_lookup(&lookups[i], &LOOKUP_LAYOUT_FOR_ORIENTATION[i]);
+    }
+    select_lookup();
+}
+
 static void adjust_camera_position_for_pixels(void)
 {
     while (data.camera.pixel.x < 0) {
@@ -156,9 +174,10 @@ static void adjust_camera_position_for_pixels(void)
 
 void city_view_init(void)
 {
-    calculate_lookup();
+    calculate_lookups();
     check_camera_boundaries();
     widget_minimap_invalidate();
+    city_with_overlay_update();
 }
 
 int city_view_orientation(void)
@@ -169,7 +188,7 @@ int city_view_orientation(void)
 void city_view_reset_orientation(void)
 {
     data.orientation = 0;
-    calculate_lookup();
+    calculate_lookups();
 }
 
 void city_view_get_camera(int *x, int *y)
@@ -267,14 +286,19 @@ void city_view_scroll(int x, int y)
 void city_view_grid_offset_to_xy_view(int grid_offset, int *x_view, int *y_view)
 {
     *x_view = *y_view = 0;
-    for (int y = 0; y < VIEW_Y_MAX; y++) {
-        for (int x = 0; x < VIEW_X_MAX; x++) {
-            if (view_to_grid_offset_lookup[x][y] == grid_offset) {
-                *x_view = x;
-                *y_view = y;
-                return;
-            }
-        }
+    if (grid_offset < 0 || grid_offset >= GRID_SIZE * GRID_SIZE) {
+        return;
+    }
+    const lookup_layout *layout = &LOOKUP_LAYOUT_FOR_ORIENTATION[data.orientation / 2];
+    int x = grid_offset % GRID_SIZE;
+    int y = grid_offset / GRID_SIZE;
+    int x_lookup = (layout->x_view_start + y * layout->x_view_skip + x * layout->x_view_step) / 2;
+    int y_lookup = layout->y_view_start + y * layout->y_view_skip + x * layout->y_view_step;
+    // tiles outside the visible map are not in the lookup
+    if (x_lookup >= 0 && x_lookup < VIEW_X_MAX && y_lookup >= 0 && y_lookup < VIEW_Y_MAX &&
+        lookup->grid_offset[y_lookup][x_lookup] == grid_offset) {
+        *x_view = x_lookup;
+        *y_view = y_lookup;
     }
 }
 
@@ -336,7 +360,7 @@ void city_view_set_selected_view_tile(const view_tile *tile)
 
 int city_view_tile_to_grid_offset(const view_tile *tile)
 {
-    int grid_offset = view_to_grid_offset_lookup[tile->x][tile->y];
+    int grid_offset = lookup->grid_offset[tile->y][tile->x];
     return grid_offset < 0 ? 0 : grid_offset;
 }
 
@@ -354,7 +378,7 @@ static int get_center_grid_offset(void)
 {
     int x_center = data.camera.tile.x + data.viewport.width_tiles / 2;
     int y_center = data.camera.tile.y + data.viewport.height_tiles / 2;
-    return view_to_grid_offset_lookup[x_center][y_center];
+    return lookup->grid_offset[y_center][x_center];
 }
 
 void city_view_rotate_left(void)
@@ -365,7 +389,7 @@ void city_view_rotate_left(void)
     if (data.orientation > 6) {
         data.orientation = DIR_0_TOP;
     }
-    calculate_lookup();
+    select_lookup();
     if (center_grid_offset >= 0) {
         int x, y;
         city_view_grid_offset_to_xy_view(center_grid_offset, &x, &y);
@@ -383,7 +407,7 @@ void city_view_rotate_right(void)
     if (data.orientation < 0) {
         data.orientation = DIR_6_LEFT;
     }
-    calculate_lookup();
+    select_lookup();
     if (center_grid_offset >= 0) {
         int x, y;
         city_view_grid_offset_to_xy_view(center_grid_offset, &x, &y);
@@ -495,135 +519,116 @@ void city_view_load_scenario_state(buffer *camera)
     data.camera.tile.y = buffer_read_i32(camera);
 }
 
+static int get_visible_row(int y_view, int odd, int valid_only, view_row *row)
+{
+    int x_view = data.camera.tile.x - 4;
+    int x_view_end = x_view + data.viewport.width_tiles + 7;
+    int first = 0;
+    int end = VIEW_X_MAX;
+    if (valid_only) {
+        first = lookup->valid_tiles[y_view].first;
+        end = lookup->valid_tiles[y_view].end;
+    }
+    row->x_graphic = data.viewport.x - (4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
+    if (odd) {
+        row->x_graphic -= HALF_TILE_WIDTH_PIXELS;
+    }
+    if (x_view < first) {
+        row->x_graphic += (first - x_view) * TILE_WIDTH_PIXELS;
+        x_view = first;
+    }
+    if (x_view_end > end) {
+        x_view_end = end;
+    }
+    row->x_view_start = x_view;
+    row->x_view_end = x_view_end;
+    return x_view < x_view_end;
+}
+
+static void foreach_tile_in_row(const view_row *row, int y_view, int y_graphic, map_callback *callback)
+{
+    const int16_t *grid_offsets = lookup->grid_offset[y_view];
+    int x_graphic = row->x_graphic;
+    for (int x_view = row->x_view_start; x_view < row->x_view_end; x_view++) {
+        callback(x_graphic, y_graphic, grid_offsets[x_view]);
+        x_graphic += TILE_WIDTH_PIXELS;
+    }
+}
+
+static void foreach_valid_tile_in_row(const view_row *row, int y_view, int y_graphic, map_callback *callback)
+{
+    const int16_t *grid_offsets = lookup->grid_offset[y_view];
+    int x_graphic = row->x_graphic;
+    for (int x_view = row->x_view_start; x_view < row->x_view_end; x_view++) {
+        int grid_offset = grid_offsets[x_view];
+        if (grid_offset >= 0) {
+            callback(x_graphic, y_graphic, grid_offset);
+        }
+        x_graphic += TILE_WIDTH_PIXELS;
+    }
+}
+
+static int get_first_visible_row(int *y_view, int *y_graphic)
+{
+    *y_view = data.camera.tile.y - 8;
+    *y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
+    int rows = data.viewport.height_tiles + 21;
+    if (*y_view < 0) {
+        rows += *y_view;
+        *y_graphic -= *y_view * HALF_TILE_HEIGHT_PIXELS;
+        *y_view = 0;
+    }
+    if (*y_view + rows > VIEW_Y_MAX) {
+        rows = VIEW_Y_MAX - *y_view;
+    }
+    return rows;
+}
+
 void city_view_foreach_map_tile(map_callback *callback)
 {
-    int odd = 0;
-    int y_view = data.camera.tile.y - 8;
-    int y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
-    for (int y = 0; y < data.viewport.height_tiles + 21; y++) {
-        if (y_view >= 0 && y_view < VIEW_Y_MAX) {
-            int x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-            if (odd) {
-                x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-            } else {
-                x_graphic += data.viewport.x;
-            }
-            int x_view = data.camera.tile.x - 4;
-            for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                    int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                    callback(x_graphic, y_graphic, grid_offset);
-                }
-                x_graphic += TILE_WIDTH_PIXELS;
-                x_view++;
-            }
+    int y_view, y_graphic;
+    int rows = get_first_visible_row(&y_view, &y_graphic);
+    int odd = (y_view - (data.camera.tile.y - 8)) & 1;
+    for (int y = 0; y < rows; y++, y_view++, y_graphic += HALF_TILE_HEIGHT_PIXELS, odd = 1 - odd) {
+        view_row row;
+        if (get_visible_row(y_view, odd, 0, &row)) {
+            foreach_tile_in_row(&row, y_view, y_graphic, callback);
         }
-        odd = 1 - odd;
-        y_graphic += HALF_TILE_HEIGHT_PIXELS;
-        y_view++;
     }
 }
 
 void city_view_foreach_valid_map_tile(map_callback *callback)
 {
-    int odd = 0;
-    int y_view = data.camera.tile.y - 8;
-    int y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
-    for (int y = 0; y < data.viewport.height_tiles + 21; y++) {
-        if (y_view >= 0 && y_view < VIEW_Y_MAX) {
-            int x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-            if (odd) {
-                x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-            } else {
-                x_graphic += data.viewport.x;
-            }
-            int x_view = data.camera.tile.x - 4;
-            for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                    int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                    if (grid_offset >= 0) {
-                        callback(x_graphic, y_graphic, grid_offset);
-                    }
-                }
-                x_graphic += TILE_WIDTH_PIXELS;
-                x_view++;
-            }
+    int y_view, y_graphic;
+    int rows = get_first_visible_row(&y_view, &y_graphic);
+    int odd = (y_view - (data.camera.tile.y - 8)) & 1;
+    for (int y = 0; y < rows; y++, y_view++, y_graphic += HALF_TILE_HEIGHT_PIXELS, odd = 1 - odd) {
+        view_row row;
+        if (get_visible_row(y_view, odd, 1, &row)) {
+            foreach_valid_tile_in_row(&row, y_view, y_graphic, callback);
         }
-        odd = 1 - odd;
-        y_graphic += HALF_TILE_HEIGHT_PIXELS;
-        y_view++;
     }
 }
 
 void city_view_foreach_valid_map_tile_row(map_callback *callback1, map_callback *callback2, map_callback *callback3)
 {
-    int odd = 0;
-    int y_view = data.camera.tile.y - 8;
-    int y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
-    int x_graphic, x_view;
-    for (int y = 0; y < data.viewport.height_tiles + 21; y++) {
-        if (y_view >= 0 && y_view < VIEW_Y_MAX) {
-            if (callback1) {
-                x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-                if (odd) {
-                    x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-                } else {
-                    x_graphic += data.viewport.x;
-                }
-                x_view = data.camera.tile.x - 4;
-                for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                    if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                        int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                        if (grid_offset >= 0) {
-                            callback1(x_graphic, y_graphic, grid_offset);
-                        }
-                    }
-                    x_graphic += TILE_WIDTH_PIXELS;
-                    x_view++;
-                }
-            }
-            if (callback2) {
-                x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-                if (odd) {
-                    x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-                } else {
-                    x_graphic += data.viewport.x;
-                }
-                x_view = data.camera.tile.x - 4;
-                for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                    if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                        int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                        if (grid_offset >= 0) {
-                            callback2(x_graphic, y_graphic, grid_offset);
-                        }
-                    }
-                    x_graphic += TILE_WIDTH_PIXELS;
-                    x_view++;
-                }
-            }
-            if (callback3) {
-                x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-                if (odd) {
-                    x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-                } else {
-                    x_graphic += data.viewport.x;
-                }
-                x_view = data.camera.tile.x - 4;
-                for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                    if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                        int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                        if (grid_offset >= 0) {
-                            callback3(x_graphic, y_graphic, grid_offset);
-                        }
-                    }
-                    x_graphic += TILE_WIDTH_PIXELS;
-                    x_view++;
-                }
-            }
+    int y_view, y_graphic;
+    int rows = get_first_visible_row(&y_view, &y_graphic);
+    int odd = (y_view - (data.camera.tile.y - 8)) & 1;
+    for (int y = 0; y < rows; y++, y_view++, y_graphic += HALF_TILE_HEIGHT_PIXELS, odd = 1 - odd) {
+        view_row row;
+        if (!get_visible_row(y_view, odd, 1, &row)) {
+            continue;
+        }
+        if (callback1) {
+            foreach_valid_tile_in_row(&row, y_view, y_graphic, callback1);
+        }
+        if (callback2) {
+            foreach_valid_tile_in_row(&row, y_view, y_graphic, callback2);
+        }
+        if (callback3) {
+            foreach_valid_tile_in_row(&row, y_view, y_graphic, callback3);
         }
-        odd = 1 - odd;
-        y_graphic += HALF_TILE_HEIGHT_PIXELS;
-        y_view++;
     }
 }
 
@@ -728,11 +733,21 @@ void city_view_foreach_minimap_tile(
             x_view = x_offset - 8;
             odd = 1;
         }
+        if (y_abs < 0 || y_abs >= VIEW_Y_MAX) {
+            continue;
+        }
         int x_abs = absolute_x - 4;
-        for (int x_rel = -4; x_rel < width_tiles; x_rel++, x_abs++, x_view += 2) {
-            if (x_abs >= 0 && x_abs < VIEW_X_MAX && y_abs >= 0 && y_abs < VIEW_Y_MAX) {
-                callback(x_view, y_view, view_to_grid_offset_lookup[x_abs][y_abs]);
-            }
+        int x_abs_end = absolute_x + width_tiles;
+        if (x_abs < 0) {
+            x_view -= 2 * x_abs;
+            x_abs = 0;
+        }
+        if (x_abs_end > VIEW_X_MAX) {
+            x_abs_end = VIEW_X_MAX;
+        }
+        const int16_t *grid_offsets = lookup->grid_offset[y_abs];
+        for (; x_abs < x_abs_end; x_abs++, x_view += 2) {
+            callback(x_view, y_view, grid_offsets[x_abs]);
         }
     }
 }
@@ -14,8 +14,11 @@ static const char *INI_FILENAME = "julius.ini";
 static const char *ini_keys[] = {
     "gameplay_fix_immigration",
     "gameplay_fix_100y_ghosts",
+    "gameplay_extend_entity_limits",
+    "gameplay_save_compression_level",
     "screen_display_scale",
     "screen_cursor_scale",
+    "screen_image_cache_mb",
     "ui_sidebar_info",
     "ui_show_intro_video",
     "ui_smooth_scrolling",
@@ -40,7 +43,8 @@ static char string_values[CONFIG_STRING_MAX_ENTRIES][CONFIG_STRING_VALUE_MAX];
 
 static int default_values[CONFIG_MAX_ENTRIES] = {
     [CONFIG_SCREEN_DISPLAY_SCALE] = 100,
-    [CONFIG_SCREEN_CURSOR_SCALE] = 100
+    [CONFIG_SCREEN_CURSOR_SCALE] = 100,
+    [CONFIG_SCREEN_IMAGE_CACHE_SIZE] = 32
 };
 static const char default_string_values[CONFIG_STRING_MAX_ENTRIES][CONFIG_STRING_VALUE_MAX];
 
@@ -6,8 +6,11 @@
 typedef enum {
     CONFIG_GP_FIX_IMMIGRATION_BUG,
     CONFIG_GP_FIX_100_YEAR_GHOSTS,
+    CONFIG_GP_EXTEND_ENTITY_LIMITS,
+    CONFIG_GP_SAVE_COMPRESSION_LEVEL,
     CONFIG_SCREEN_DISPLAY_SCALE,
     CONFIG_SCREEN_CURSOR_SCALE,
+    CONFIG_SCREEN_IMAGE_CACHE_SIZE,
     CONFIG_UI_SIDEBAR_INFO,
     CONFIG_UI_SHOW_INTRO_VIDEO,
     CONFIG_UI_SMOOTH_SCROLLING,
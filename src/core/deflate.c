@@ -0,0 +1,439 @@
+#include "core/deflate.h"
+
+#include "core/log.h"
+
+#include "zlib/zlib.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_BUFFER_SIZE 16384
+#define FAST_BITS 10
+#define MAX_CODE_BITS 15
+#define MAX_LITERAL_CODES 288
+#define MAX_DISTANCE_CODES 30
+#define NUM_CODE_LENGTH_CODES 19
+#define END_OF_BLOCK 256
+
+typedef struct {
+    // symbol << 4 | code length for every code of up to FAST_BITS bits, 0 for longer codes
+    uint16_t fast[1 << FAST_BITS];
+    uint16_t count[MAX_CODE_BITS + 1];
+    uint16_t symbol[MAX_LITERAL_CODES];
+} huffman_table;
+
+typedef struct {
+    deflate_read_func read_func;
+    void *userdata;
+    uint8_t input[INPUT_BUFFER_SIZE];
+    int input_ptr;
+    int input_end;
+
+    uint64_t bits;
+    int bit_count;
+    int padding_bytes;
+
+    uint8_t *output;
+    int output_ptr;
+    int output_length;
+
+    huffman_table literals;
+    huffman_table distances;
+} inflate_state;
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra_bits[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t distance_base[MAX_DISTANCE_CODES] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t distance_extra_bits[MAX_DISTANCE_CODES] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t code_length_order[NUM_CODE_LENGTH_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+int deflate_max_compressed_size(int input_length)
+{
+    return (int) deflateBound(0, (uLong) input_length);
+}
+
+int deflate_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length, int level)
+{
+    if (level < DEFLATE_MIN_LEVEL) {
+        level = DEFLATE_MIN_LEVEL;
+    } else if (level > DEFLATE_MAX_LEVEL) {
+        level = DEFLATE_MAX_LEVEL;
+    }
+    z_stream stream;
+    memset(&stream, 0, sizeof(z_stream));
+    if (deflateInit(&stream, level) != Z_OK) {
+        log_error("Unable to compress data: out of memory", 0, 0);
+        return 0;
+    }
+    stream.next_in = (Bytef *) input_buffer;
+    stream.avail_in = (uInt) input_length;
+    stream.next_out = (Bytef *) output_buffer;
+    stream.avail_out = (uInt) *output_length;
+    int result = deflate(&stream, Z_FINISH);
+    if (result == Z_STREAM_END) {
+        *output_length = (int) stream.total_out;
+    } else {
+        log_error("Unable to compress data", 0, result);
+    }
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+static void fill_bits(inflate_state *s)
+{
+    while (s->bit_count <= 56) {
+        if (s->input_ptr == s->input_end) {
+            s->input_ptr = 0;
+            s->input_end = s->read_func(s->input, INPUT_BUFFER_SIZE, s->userdata);
+            if (s->input_end <= 0) {
+                // zeros past the end, decoding fails when they are used
+                s->input_end = 0;
+                s->padding_bytes++;
+                s->bit_count += 8;
+                continue;
+            }
+        }
+        s->bits |= (uint64_t) s->input[s->input_ptr++] << s->bit_count;
+        s->bit_count += 8;
+    }
+}
+
+static int used_padding(const inflate_state *s)
+{
+    return s->padding_bytes * 8 > s->bit_count;
+}
+
+static void drop_bits(inflate_state *s, int num_bits)
+{
+    s->bits >>= num_bits;
+    s->bit_count -= num_bits;
+}
+
+static int get_bits(inflate_state *s, int num_bits)
+{
+    if (s->bit_count < num_bits) {
+        fill_bits(s);
+    }
+    int value = (int) (s->bits & ((1u << num_bits) - 1));
+    drop_bits(s, num_bits);
+    return value;
+}
+
+static int build_huffman_table(huffman_table *table, const uint8_t *lengths, int num_codes)
+{
+    memset(table->count, 0, sizeof(table->count));
+    memset(table->fast, 0, sizeof(table->fast));
+    for (int i = 0; i < num_codes; i++) {
+        table->count[lengths[i]]++;
+    }
+    table->count[0] = 0;
+    int left = 1;
+    for (int length = 1; length <= MAX_CODE_BITS; length++) {
+        left <<= 1;
+        left -= table->count[length];
+        if (left < 0) {
+            // more codes than fit in the number of bits
+            return 0;
+        }
+    }
+    uint16_t offsets[MAX_CODE_BITS + 1];
+    offsets[1] = 0;
+    for (int length = 1; length < MAX_CODE_BITS; length++) {
+        offsets[length + 1] = offsets[length] + table->count[length];
+    }
+    for (int i = 0; i < num_codes; i++) {
+        if (lengths[i]) {
+            table->symbol[offsets[lengths[i]]++] = (uint16_t) i;
+        }
+    }
+    // codes are stored starting with their highest bit, so the fast table is indexed by the reversed code
+    int code = 0;
+    int index = 0;
+    for (int length = 1; length <= FAST_BITS; length++) {
+        for (int i = 0; i < table->count[length]; i++) {
+            int reversed = 0;
+            for (int bit = 0; bit < length; bit++) {
+                reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+            }
+            uint16_t entry = (uint16_t) (table->symbol[index++] << 4 | length);
+            for (int f = reversed; f < (1 << FAST_BITS); f += 1 << length) {
+                table->fast[f] = entry;
+            }
+            code++;
+        }
+        code <<= 1;
+    }
+    return 1;
+}
+
+static int decode_symbol(inflate_state *s, const huffman_table *table)
+{
+    if (s->bit_count < MAX_CODE_BITS) {
+        fill_bits(s);
+    }
+    int entry = table->fast[s->bits & ((1 << FAST_BITS) - 1)];
+    if (entry) {
+        drop_bits(s, entry & 0xf);
+        return entry >> 4;
+    }
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length <= MAX_CODE_BITS; length++) {
+        code |= (int) (s->bits >> (length - 1)) & 1;
+        int count = table->count[length];
+        if (code - count < first) {
+            drop_bits(s, length);
+            return table->symbol[index + code - first];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static int inflate_stored_block(inflate_state *s)
+{
+    drop_bits(s, s->bit_count & 7);
+    int length = get_bits(s, 16);
+    int complement = get_bits(s, 16);
+    if (length != (~complement & 0xffff) || length > s->output_length - s->output_ptr) {
+        return 0;
+    }
+    while (length > 0 && s->bit_count >= 8) {
+        s->output[s->output_ptr++] = (uint8_t) get_bits(s, 8);
+        length--;
+    }
+    if (used_padding(s)) {
+        return 0;
+    }
+    while (length > 0) {
+        if (s->input_ptr == s->input_end) {
+            s->input_ptr = 0;
+            s->input_end = s->read_func(s->input, INPUT_BUFFER_SIZE, s->userdata);
+            if (s->input_end <= 0) {
+                return 0;
+            }
+        }
+        int bytes = s->input_end - s->input_ptr;
+        if (bytes > length) {
+            bytes = length;
+        }
+        memcpy(&s->output[s->output_ptr], &s->input[s->input_ptr], bytes);
+        s->output_ptr += bytes;
+        s->input_ptr += bytes;
+        length -= bytes;
+    }
+    return 1;
+}
+
+static void copy_match(uint8_t *dst, int distance, int length)
+{
+    const uint8_t *src = dst - distance;
+    if (distance == 1) {
+        memset(dst, *src, (size_t) length);
+        return;
+    }
+    // the source may overlap the copied bytes, so copy at most distance bytes at a time
+    while (distance >= 8 && length >= 8) {
+        memcpy(dst, src, 8);
+        dst += 8;
+        src += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        *dst++ = *src++;
+    }
+}
+
+static int inflate_huffman_block(inflate_state *s)
+{
+    while (1) {
+        int symbol = decode_symbol(s, &s->literals);
+        if (symbol < 0 || used_padding(s)) {
+            return 0;
+        }
+        if (symbol < END_OF_BLOCK) {
+            if (s->output_ptr >= s->output_length) {
+                return 0;
+            }
+            s->output[s->output_ptr++] = (uint8_t) symbol;
+            continue;
+        }
+        if (symbol == END_OF_BLOCK) {
+            return 1;
+        }
+        symbol -= END_OF_BLOCK + 1;
+        if (symbol >= 29) {
+            return 0;
+        }
+        int length = length_base[symbol] + get_bits(s, length_extra_bits[symbol]);
+        symbol = decode_symbol(s, &s->distances);
+        if (symbol < 0 || symbol >= MAX_DISTANCE_CODES) {
+            return 0;
+        }
+        int distance = distance_base[symbol] + get_bits(s, distance_extra_bits[symbol]);
+        if (used_padding(s) || distance > s->output_ptr || length > s->output_length - s->output_ptr) {
+            return 0;
+        }
+        copy_match(&s->output[s->output_ptr], distance, length);
+        s->output_ptr += length;
+    }
+}
+
+static void build_fixed_tables(inflate_state *s)
+{
+    uint8_t lengths[MAX_LITERAL_CODES];
+    memset(lengths, 8, 144);
+    memset(&lengths[144], 9, 256 - 144);
+    memset(&lengths[256], 7, 280 - 256);
+    memset(&lengths[280], 8, MAX_LITERAL_CODES - 280);
+    build_huffman_table(&s->literals, lengths, MAX_LITERAL_CODES);
+    memset(lengths, 5, MAX_DISTANCE_CODES);
+    build_huffman_table(&s->distances, lengths, MAX_DISTANCE_CODES);
+}
+
+static int build_dynamic_tables(inflate_state *s)
+{
+    int num_literals = get_bits(s, 5) + 257;
+    int num_distances = get_bits(s, 5) + 1;
+    int num_code_lengths = get_bits(s, 4) + 4;
+    if (num_literals > 286 || num_distances > MAX_DISTANCE_CODES) {
+        return 0;
+    }
+    uint8_t lengths[MAX_LITERAL_CODES + MAX_DISTANCE_CODES];
+    memset(lengths, 0, NUM_CODE_LENGTH_CODES);
+    for (int i = 0; i < num_code_lengths; i++) {
+        lengths[code_length_order[i]] = (uint8_t) get_bits(s, 3);
+    }
+    // the code lengths are decoded with the literal table, which is built again below
+    if (!build_huffman_table(&s->literals, lengths, NUM_CODE_LENGTH_CODES)) {
+        return 0;
+    }
+    int index = 0;
+    while (index < num_literals + num_distances) {
+        int symbol = decode_symbol(s, &s->literals);
+        if (symbol < 0 || used_padding(s)) {
+            return 0;
+        }
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t) symbol;
+            continue;
+        }
+        uint8_t length = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return 0;
+            }
+            length = lengths[index - 1];
+            repeat = 3 + get_bits(s, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + get_bits(s, 3);
+        } else {
+            repeat = 11 + get_bits(s, 7);
+        }
+        if (index + repeat > num_literals + num_distances) {
+            return 0;
+        }
+        memset(&lengths[index], length, repeat);
+        index += repeat;
+    }
+    if (!lengths[END_OF_BLOCK]) {
+        return 0;
+    }
+    return build_huffman_table(&s->literals, lengths, num_literals) &&
+        build_huffman_table(&s->distances, &lengths[num_literals], num_distances);
+}
+
+static int inflate_stream(inflate_state *s)
+{
+    int header = get_bits(s, 8) << 8;
+    header |= get_bits(s, 8);
+    // deflate with a window of at most 32 kB, without preset dictionary
+    if ((header & 0x0f00) != 0x0800 || (header >> 12) > 7 || header % 31 || (header & 0x20)) {
+        return 0;
+    }
+    int last_block;
+    do {
+        last_block = get_bits(s, 1);
+        int ok;
+        switch (get_bits(s, 2)) {
+            case 0:
+                ok = inflate_stored_block(s);
+                break;
+            case 1:
+                build_fixed_tables(s);
+                ok = inflate_huffman_block(s);
+                break;
+            case 2:
+                ok = build_dynamic_tables(s) && inflate_huffman_block(s);
+                break;
+            default:
+                ok = 0;
+                break;
+        }
+        if (!ok) {
+            return 0;
+        }
+    } while (!last_block);
+
+    drop_bits(s, s->bit_count & 7);
+    uLong checksum = (uLong) get_bits(s, 8) << 24;
+    checksum |= (uLong) get_bits(s, 8) << 16;
+    checksum |= (uLong) get_bits(s, 8) << 8;
+    checksum |= (uLong) get_bits(s, 8);
+    if (used_padding(s)) {
+        return 0;
+    }
+    return checksum == adler32(adler32(0, 0, 0), s->output, (uInt) s->output_ptr);
+}
+
+int deflate_decompress(deflate_read_func read_func, void *userdata, void *output_buffer, int *output_length)
+{
+    inflate_state *s = (inflate_state *) malloc(sizeof(inflate_state));
+    if (!s) {
+        log_error("Unable to decompress data: out of memory", 0, 0);
+        return 0;
+    }
+    s->read_func = read_func;
+    s->userdata = userdata;
+    s->input_ptr = 0;
+    s->input_end = 0;
+    s->bits = 0;
+    s->bit_count = 0;
+    s->padding_bytes = 0;
+    s->output = (uint8_t *) output_buffer;
+    s->output_ptr = 0;
+    s->output_length = *output_length;
+
+    int ok = inflate_stream(s);
+    if (ok) {
+        *output_length = s->output_ptr;
+    } else {
+        log_error("Unable to decompress data", 0, 0);
+    }
+    free(s);
+    return ok;
+}
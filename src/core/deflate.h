@@ -0,0 +1,53 @@
+#ifndef CORE_DEFLATE_H
+#define CORE_DEFLATE_H
+
+/**
+ * @file
+ * Deflate compression in the zlib format.
+ *
+ * Compressing uses zlib, decompressing has its own decoder because the
+ * included zlib only contains the compressor.
+ */
+
+#define DEFLATE_MIN_LEVEL 1
+#define DEFLATE_MAX_LEVEL 9
+
+/**
+ * Function that provides compressed data to the decoder
+ * @param buffer Buffer to read the data to
+ * @param length Maximum number of bytes to read
+ * @param userdata Userdata passed to deflate_decompress
+ * @return Number of bytes read, 0 when there is no more data
+ */
+typedef int (*deflate_read_func)(void *buffer, int length, void *userdata);
+
+/**
+ * Gets the maximum size of compressed data
+ * @param input_length Length of the data to compress
+ * @return Size that is always enough for the compressed data
+ */
+int deflate_max_compressed_size(int input_length);
+
+/**
+ * Compresses the input buffer.
+ * @param input_buffer Input buffer to compress
+ * @param input_length Length of input buffer
+ * @param output_buffer Output buffer to write the compressed data to
+ * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @param level Compression level, from DEFLATE_MIN_LEVEL (fastest) to DEFLATE_MAX_LEVEL (smallest)
+ * @return boolean true on success, false on error
+ */
+int deflate_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length, int level);
+
+/**
+ * Decompresses data that is read in parts, directly into the output buffer.
+ * The read function must not return data past the end of the compressed data.
+ * @param read_func Function that reads the compressed data
+ * @param userdata Userdata for the read function
+ * @param output_buffer Output buffer to write decompressed data to
+ * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @return boolean true on success, false on error
+ */
+int deflate_decompress(deflate_read_func read_func, void *userdata, void *output_buffer, int *output_length);
+
+#endif // CORE_DEFLATE_H
@@ -16,6 +16,21 @@ int file_close(FILE *stream)
     return platform_file_manager_close_file(stream);
 }
 
+void file_sync(FILE *stream)
+{
+    platform_file_manager_sync_file(stream);
+}
+
+const void *file_map(const char *filename, int *size)
+{
+    return platform_file_manager_map_file(filename, size);
+}
+
+void file_unmap(const void *data, int size)
+{
+    platform_file_manager_unmap_file(data, size);
+}
+
 int file_has_extension(const char *filename, const char *extension)
 {
     if (!extension || !*extension) {
@@ -84,3 +99,18 @@ int file_remove(const char *filename)
 {
     return platform_file_manager_remove_file(filename);
 }
+
+int file_can_write_in_background(void)
+{
+    return platform_file_manager_can_write_in_background();
+}
+
+int file_can_replace(void)
+{
+    return platform_file_manager_can_replace_file();
+}
+
+int file_replace(const char *source, const char *target)
+{
+    return platform_file_manager_replace_file(source, target);
+}
@@ -33,6 +33,27 @@ FILE *file_open(const char *filename, const char *mode);
  */
 int file_close(FILE *stream);
 
+/**
+ * Writes everything written to the file to the disk
+ * @param stream Stream to sync
+ */
+void file_sync(FILE *stream);
+
+/**
+ * Maps a file into memory for reading
+ * @param filename Exact filename of the file to map
+ * @param size Set to the size of the file
+ * @return Contents of the file, or NULL if the file cannot be mapped
+ */
+const void *file_map(const char *filename, int *size);
+
+/**
+ * Unmaps a file mapped with file_map
+ * @param data Contents of the file
+ * @param size Size of the file
+ */
+void file_unmap(const void *data, int size);
+
 /**
  * Checks whether the file has the given extension
  * @param filename Filename to check
@@ -77,4 +98,24 @@ int file_exists(const char *filename, int localizable);
  */
 int file_remove(const char *filename);
 
+/**
+ * Check whether files can be written from a background thread
+ * @return boolean true if files can be written in the background, false otherwise
+ */
+int file_can_write_in_background(void);
+
+/**
+ * Check whether files can be renamed, replacing the target file
+ * @return boolean true if file_replace is supported, false otherwise
+ */
+int file_can_replace(void);
+
+/**
+ * Rename a file, replacing the target file in a single step
+ * @param source Filename to rename
+ * @param target New filename, replaced if it exists
+ * @return boolean true if the file was renamed, false if renaming failed or is not supported
+ */
+int file_replace(const char *source, const char *target);
+
 #endif // CORE_FILE_H
@@ -4,7 +4,9 @@
 #include "core/file.h"
 #include "core/io.h"
 #include "core/log.h"
+#include "game/system.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -38,6 +40,13 @@
 #define GREEK_FONT_BASE_OFFSET 1
 
 #define NAME_SIZE 32
+#define MAX_GROUPS 300
+
+#define MAX_CONVERT_TASKS 64
+#define CONVERT_TASKS_PER_THREAD 4
+
+#define EXTERNAL_CACHE_MAX_ENTRIES 128
+#define EXTERNAL_SCRATCH_OFFSET 4000000
 
 enum {
     NO_EXTRA_FONT = 0,
@@ -124,11 +133,12 @@ static const image DUMMY_IMAGE;
 
 static struct {
     int current_climate;
+    int climate_version;
     int is_editor;
     int fonts_enabled;
     int font_base_offset;
 
-    uint16_t group_image_ids[300];
+    uint16_t group_image_ids[MAX_GROUPS];
     char bitmaps[100][200];
     image main[MAIN_ENTRIES];
     image enemy[ENEMY_ENTRIES];
@@ -140,6 +150,23 @@ static struct {
     uint8_t *tmp_data;
 } data = {.current_climate = -1};
 
+typedef struct {
+    int image_id;
+    int size;
+    unsigned int last_used;
+    color_t *pixels;
+} external_cache_entry;
+
+// Decoded external images, least recently used are evicted first
+static struct {
+    external_cache_entry entries[EXTERNAL_CACHE_MAX_ENTRIES];
+    int num_entries;
+    uint8_t entry_for_image[MAIN_ENTRIES]; // entry index + 1, 0 when not cached
+    int total_size;
+    int max_size;
+    unsigned int use_counter;
+} external_cache;
+
 int image_init(void)
 {
     data.enemy_data = (color_t *) malloc(ENEMY_DATA_SIZE);
@@ -210,7 +237,7 @@ static void read_index(buffer *buf, image *images, int size)
 static void read_header(buffer *buf)
 {
     buffer_skip(buf, 80); // header integers
-    for (int i = 0; i < 300; i++) {
+    for (int i = 0; i < MAX_GROUPS; i++) {
         data.group_image_ids[i] = buffer_read_u16(buf);
     }
     buffer_read_raw(buf, data.bitmaps, 20000);
@@ -256,7 +283,83 @@ static int convert_compressed(buffer *buf, int buf_length, color_t *dst)
     return dst_length;
 }
 
-static void convert_images(image *images, int size, buffer *buf, color_t *dst)
+typedef struct {
+    image *images;
+    const int *dst_offsets;
+    const buffer *src;
+    color_t *dst;
+    int first_image[MAX_CONVERT_TASKS + 1];
+} convert_job;
+
+// Moves through the buffer the same way as reading the pixels one by one would
+static void skip_pixels(buffer *buf, int num_pixels)
+{
+    if (num_pixels <= 0) {
+        return;
+    }
+    int available = (buf->size - buf->index) / 2;
+    buffer_skip(buf, 2 * (num_pixels < available ? num_pixels : available));
+}
+
+// Same result as convert_compressed, without converting the pixels
+static int compressed_length(buffer *buf, int buf_length)
+{
+    int dst_length = 0;
+    while (buf_length > 0) {
+        int control = buffer_read_u8(buf);
+        if (control == 255) {
+            buffer_read_u8(buf);
+            dst_length += 2;
+            buf_length -= 2;
+        } else {
+            skip_pixels(buf, control);
+            dst_length += control + 1;
+            buf_length -= control * 2 + 1;
+        }
+    }
+    return dst_length;
+}
+
+static int converted_length(buffer *buf, const image *img)
+{
+    buffer_set(buf, img->draw.offset);
+    if (img->draw.is_fully_compressed) {
+        return compressed_length(buf, img->draw.data_length);
+    } else if (img->draw.has_compressed_part) {
+        skip_pixels(buf, img->draw.uncompressed_length / 2);
+        return img->draw.uncompressed_length / 2 +
+            compressed_length(buf, img->draw.data_length - img->draw.uncompressed_length);
+    } else {
+        return img->draw.data_length / 2;
+    }
+}
+
+static void convert_image(buffer *buf, const image *img, color_t *dst)
+{
+    buffer_set(buf, img->draw.offset);
+    if (img->draw.is_fully_compressed) {
+        convert_compressed(buf, img->draw.data_length, dst);
+    } else if (img->draw.has_compressed_part) { // isometric tile
+        dst += convert_uncompressed(buf, img->draw.uncompressed_length, dst);
+        convert_compressed(buf, img->draw.data_length - img->draw.uncompressed_length, dst);
+    } else {
+        convert_uncompressed(buf, img->draw.data_length, dst);
+    }
+}
+
+static void convert_images_task(int task_id, void *userdata)
+{
+    const convert_job *job = (const convert_job *) userdata;
+    buffer buf;
+    buffer_init(&buf, job->src->data, job->src->size);
+    for (int i = job->first_image[task_id]; i < job->first_image[task_id + 1]; i++) {
+        if (!job->images[i].draw.is_external) {
+            convert_image(&buf, &job->images[i], &job->dst[job->dst_offsets[i]]);
+        }
+    }
+}
+
+static void convert_images_sequential(image *images, int size, buffer *buf, color_t *dst)
 {
     color_t *start_dst = dst;
     dst++; // make sure img->offset > 0
@@ -280,16 +383,170 @@ static void convert_images(image *images, int size, buffer *buf, color_t *dst)
     }
 }
 
+static int is_valid_for_parallel_convert(const image *img, const buffer *buf)
+{
+    if (img->draw.offset < 0 || img->draw.data_length < 0 || img->draw.offset + img->draw.data_length > buf->size) {
+        return 0;
+    }
+    // odd lengths of uncompressed pixels make the image overlap the next one by a pixel,
+    // which only gives the right result when converting one by one
+    if (img->draw.has_compressed_part) {
+        return (img->draw.uncompressed_length & 1) == 0;
+    }
+    return img->draw.is_fully_compressed || (img->draw.data_length & 1) == 0;
+}
+
+/**
+ * Converts the images on worker threads. The lengths of the converted images are
+ * calculated first, so every image ends up at the same offset as when converting
+ * them one by one.
+ */
+static void convert_images(image *images, int size, buffer *buf, color_t *dst)
+{
+    int threads = system_task_thread_count();
+    int *dst_offsets = threads > 1 ? (int *) malloc(size * sizeof(int)) : 0;
+    if (!dst_offsets) {
+        convert_images_sequential(images, size, buf, dst);
+        return;
+    }
+    int total_length = 0;
+    int offset = 1; // make sure img->offset > 0
+    for (int i = 0; i < size; i++) {
+        const image *img = &images[i];
+        if (img->draw.is_external) {
+            continue;
+        }
+        if (!is_valid_for_parallel_convert(img, buf)) {
+            free(dst_offsets);
+            convert_images_sequential(images, size, buf, dst);
+            return;
+        }
+        dst_offsets[i] = offset;
+        offset += converted_length(buf, img);
+        total_length += img->draw.data_length;
+    }
+
+    convert_job job = { images, dst_offsets, buf, dst };
+    int num_tasks = threads * CONVERT_TASKS_PER_THREAD;
+    if (num_tasks > MAX_CONVERT_TASKS) {
+        num_tasks = MAX_CONVERT_TASKS;
+    }
+    // split the images into tasks with about the same amount of data
+    int task = 0;
+    int length = 0;
+    job.first_image[0] = 0;
+    for (int i = 0; i < size && task < num_tasks - 1; i++) {
+        if (!images[i].draw.is_external) {
+            length += images[i].draw.data_length;
+        }
+        if ((int64_t) length * num_tasks >= (int64_t) total_length * (task + 1)) {
+            job.first_image[++task] = i + 1;
+        }
+    }
+    job.first_image[++task] = size;
+    system_run_tasks(convert_images_task, task, &job);
+
+    for (int i = 0; i < size; i++) {
+        image *img = &images[i];
+        if (!img->draw.is_external) {
+            img->draw.offset = dst_offsets[i];
+            img->draw.uncompressed_length /= 2;
+        }
+    }
+    free(dst_offsets);
+}
+
+// Opens the file without copying it, limited to max_size bytes like io_read_file_into_buffer.
+// Platforms that cannot map files read it into the scratch buffer instead.
+static int open_graphics_file(const char *filename, io_file_view *view, buffer *buf, int max_size)
+{
+    if (!io_open_file_view(filename, MAY_BE_LOCALIZED, view, data.tmp_data, max_size)) {
+        return 0;
+    }
+    int size = view->size;
+    if (!size) {
+        io_close_file_view(view);
+        return 0;
+    }
+    buffer_init(buf, (void *) view->data, size);
+    return size;
+}
+
+// Opens part of an index file, which must be completely present
+static int open_index_file(const char *filename, io_file_view *view, buffer *buf, int offset, int size)
+{
+    if (!io_open_file_view(filename, MAY_BE_LOCALIZED, view, data.tmp_data, offset + size)) {
+        return 0;
+    }
+    if (view->size < offset + size) {
+        io_close_file_view(view);
+        return 0;
+    }
+    buffer_init(buf, (void *) &view->data[offset], size);
+    return 1;
+}
+
 static void load_empire(void)
 {
-    int size = io_read_file_into_buffer(EMPIRE_555, MAY_BE_LOCALIZED, data.tmp_data, EMPIRE_DATA_SIZE);
+    io_file_view view;
+    buffer buf;
+    int size = open_graphics_file(EMPIRE_555, &view, &buf, EMPIRE_DATA_SIZE);
     if (size != EMPIRE_DATA_SIZE / 2) {
+        if (size) {
+            io_close_file_view(&view);
+        }
         log_error("unable to load empire data", EMPIRE_555, 0);
         return;
     }
-    buffer buf;
-    buffer_init(&buf, data.tmp_data, size);
     convert_uncompressed(&buf, size, data.empire_data);
+    io_close_file_view(&view);
+}
+
+static void evict_external_image(int index)
+{
+    external_cache_entry *entry = &external_cache.entries[index];
+    external_cache.entry_for_image[entry->image_id] = 0;
+    external_cache.total_size -= entry->size;
+    free(entry->pixels);
+    external_cache.num_entries--;
+    if (index != external_cache.num_entries) {
+        *entry = external_cache.entries[external_cache.num_entries];
+        external_cache.entry_for_image[entry->image_id] = index + 1;
+    }
+}
+
+static void clear_external_cache(void)
+{
+    while (external_cache.num_entries > 0) {
+        evict_external_image(external_cache.num_entries - 1);
+    }
+}
+
+static int make_room_in_external_cache(int size, unsigned int keep_used_after)
+{
+    if (size > external_cache.max_size) {
+        return 0;
+    }
+    while (external_cache.num_entries >= EXTERNAL_CACHE_MAX_ENTRIES ||
+        external_cache.total_size + size > external_cache.max_size) {
+        int oldest = 0;
+        for (int i = 1; i < external_cache.num_entries; i++) {
+            if (external_cache.entries[i].last_used < external_cache.entries[oldest].last_used) {
+                oldest = i;
+            }
+        }
+        if (external_cache.entries[oldest].last_used > keep_used_after) {
+            return 0;
+        }
+        evict_external_image(oldest);
+    }
+    return 1;
+}
+
+void image_set_external_cache_size(int max_bytes)
+{
+    external_cache.max_size = max_bytes > 0 ? max_bytes : 0;
+    make_room_in_external_cache(0, UINT_MAX);
 }
 
 static void fix_animation_offsets(void)
@@ -305,36 +562,44 @@ int image_load_climate(int climate_id, int is_editor, int force_reload)
     if (climate_id == data.current_climate && is_editor == data.is_editor && !force_reload) {
         return 1;
     }
+    time_millis start_time = system_get_ticks();
 
     const char *filename_bmp = is_editor ? EDITOR_GRAPHICS_555[climate_id] : MAIN_GRAPHICS_555[climate_id];
     const char *filename_idx = is_editor ? EDITOR_GRAPHICS_SG2[climate_id] : MAIN_GRAPHICS_SG2[climate_id];
 
-    if (MAIN_INDEX_SIZE != io_read_file_into_buffer(filename_idx, MAY_BE_LOCALIZED, data.tmp_data, MAIN_INDEX_SIZE)) {
+    io_file_view index;
+    buffer buf;
+    if (!open_index_file(filename_idx, &index, &buf, 0, MAIN_INDEX_SIZE)) {
         return 0;
     }
-
-    buffer buf;
-    buffer_init(&buf, data.tmp_data, HEADER_SIZE);
     read_header(&buf);
-    buffer_init(&buf, &data.tmp_data[HEADER_SIZE], ENTRY_SIZE * MAIN_ENTRIES);
     read_index(&buf, data.main, MAIN_ENTRIES);
+    io_close_file_view(&index);
 
-    int data_size = io_read_file_into_buffer(filename_bmp, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    if (!open_graphics_file(filename_bmp, &view, &buf, SCRATCH_DATA_SIZE)) {
         return 0;
     }
-    buffer_init(&buf, data.tmp_data, data_size);
     convert_images(data.main, MAIN_ENTRIES, &buf, data.main_data);
+    io_close_file_view(&view);
+    clear_external_cache();
     data.current_climate = climate_id;
+    data.climate_version++;
     data.is_editor = is_editor;
 
     load_empire();
     if (!is_editor) {
         fix_animation_offsets();
     }
+    log_info("Climate graphics loaded in ms:", filename_bmp, (int) (system_get_ticks() - start_time));
     return 1;
 }
 
+int image_climate_version(void)
+{
+    return data.climate_version;
+}
+
 static void free_font_memory(void)
 {
     free(data.font);
@@ -363,20 +628,20 @@ static int load_external_fonts(int base_offset)
     if (!alloc_font_memory(EXTERNAL_FONT_ENTRIES, EXTERNAL_FONT_DATA_SIZE)) {
         return 0;
     }
-    if (EXTERNAL_FONT_INDEX_SIZE != io_read_file_part_into_buffer(EXTERNAL_FONTS_SG2, MAY_BE_LOCALIZED,
-        data.tmp_data, EXTERNAL_FONT_INDEX_SIZE, EXTERNAL_FONT_INDEX_OFFSET)) {
+    io_file_view index;
+    buffer buf;
+    if (!open_index_file(EXTERNAL_FONTS_SG2, &index, &buf, EXTERNAL_FONT_INDEX_OFFSET, EXTERNAL_FONT_INDEX_SIZE)) {
         return 0;
     }
-    buffer buf;
-    buffer_init(&buf, data.tmp_data, EXTERNAL_FONT_INDEX_SIZE);
     read_index(&buf, data.font, EXTERNAL_FONT_ENTRIES);
+    io_close_file_view(&index);
 
-    int data_size = io_read_file_into_buffer(EXTERNAL_FONTS_555, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    if (!open_graphics_file(EXTERNAL_FONTS_555, &view, &buf, SCRATCH_DATA_SIZE)) {
         return 0;
     }
-    buffer_init(&buf, data.tmp_data, data_size);
     convert_images(data.font, EXTERNAL_FONT_ENTRIES, &buf, data.font_data);
+    io_close_file_view(&view);
 
     data.fonts_enabled = FULL_CHARSET_IN_FONT;
     data.font_base_offset = base_offset;
@@ -466,18 +731,16 @@ static int load_traditional_chinese_fonts(void)
     }
 
     int file_version = 2;
-    int data_size = io_read_file_into_buffer(CHINESE_FONTS_555_V2, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    buffer input;
+    if (!open_graphics_file(CHINESE_FONTS_555_V2, &view, &input, SCRATCH_DATA_SIZE)) {
         file_version = 1;
-        data_size = io_read_file_into_buffer(CHINESE_FONTS_555, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-        if (!data_size) {
+        if (!open_graphics_file(CHINESE_FONTS_555, &view, &input, SCRATCH_DATA_SIZE)) {
             log_error("Julius requires extra files for Chinese characters:", CHINESE_FONTS_555_V2, 0);
             return 0;
         }
     }
 
-    buffer input;
-    buffer_init(&input, data.tmp_data, data_size);
     color_t *pixels = data.font_data;
     int offset = 0;
     int num_chars = IMAGE_FONT_MULTIBYTE_TRAD_CHINESE_MAX_CHARS;
@@ -495,6 +758,7 @@ static int load_traditional_chinese_fonts(void)
         offset = parse_chinese_font(num_chars, &input, &pixels[offset], offset, 20, num_chars * 2);
     }
     log_info("Done parsing Traditional Chinese font", 0, 0);
+    io_close_file_view(&view);
 
     data.fonts_enabled = MULTIBYTE_IN_FONT;
     data.font_base_offset = 0;
@@ -508,18 +772,16 @@ static int load_simplified_chinese_fonts(void)
     }
 
     int file_version = 2;
-    int data_size = io_read_file_into_buffer(CHINESE_FONTS_555_V2, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    buffer input;
+    if (!open_graphics_file(CHINESE_FONTS_555_V2, &view, &input, SCRATCH_DATA_SIZE)) {
         file_version = 1;
-        data_size = io_read_file_into_buffer(CHINESE_FONTS_555, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-        if (!data_size) {
+        if (!open_graphics_file(CHINESE_FONTS_555, &view, &input, SCRATCH_DATA_SIZE)) {
             log_error("Julius requires extra files for Chinese characters:", CHINESE_FONTS_555_V2, 0);
             return 0;
         }
     }
 
-    buffer input;
-    buffer_init(&input, data.tmp_data, data_size);
     color_t *pixels = data.font_data;
     int offset = 0;
     int num_chars = IMAGE_FONT_MULTIBYTE_SIMP_CHINESE_MAX_CHARS;
@@ -537,6 +799,7 @@ static int load_simplified_chinese_fonts(void)
         offset = parse_chinese_font(num_chars, &input, &pixels[offset], offset, 19, num_chars * 2);
     }
     log_info("Done parsing Simplified Chinese font", 0, 0);
+    io_close_file_view(&view);
 
     data.fonts_enabled = MULTIBYTE_IN_FONT;
     data.font_base_offset = 0;
@@ -585,18 +848,16 @@ static int load_korean_fonts(void)
     }
 
     int file_version = 2;
-    int data_size = io_read_file_into_buffer(KOREAN_FONTS_555_V2, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    buffer input;
+    if (!open_graphics_file(KOREAN_FONTS_555_V2, &view, &input, SCRATCH_DATA_SIZE)) {
         file_version = 1;
-        data_size = io_read_file_into_buffer(KOREAN_FONTS_555, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-        if (!data_size) {
+        if (!open_graphics_file(KOREAN_FONTS_555, &view, &input, SCRATCH_DATA_SIZE)) {
             log_error("Julius requires extra files for Korean characters:", KOREAN_FONTS_555, 0);
             return 0;
         }
     }
 
-    buffer input;
-    buffer_init(&input, data.tmp_data, data_size);
     color_t *pixels = data.font_data;
     int offset = 0;
     int num_chars = IMAGE_FONT_MULTIBYTE_KOREAN_MAX_CHARS;
@@ -614,6 +875,7 @@ static int load_korean_fonts(void)
         offset = parse_korean_font(&input, &pixels[offset], offset, 20, num_chars * 2);
     }
     log_info("Done parsing Korean font", 0, 0);
+    io_close_file_view(&view);
 
     data.fonts_enabled = MULTIBYTE_IN_FONT;
     data.font_base_offset = 0;
@@ -626,14 +888,13 @@ static int load_japanese_fonts(void)
         return 0;
     }
 
-    int data_size = io_read_file_into_buffer(JAPANESE_FONTS_555, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    buffer input;
+    if (!open_graphics_file(JAPANESE_FONTS_555, &view, &input, SCRATCH_DATA_SIZE)) {
         log_error("Julius requires extra files for Japanese characters:", JAPANESE_FONTS_555, 0);
         return 0;
     }
 
-    buffer input;
-    buffer_init(&input, data.tmp_data, data_size);
     color_t *pixels = data.font_data;
     int offset = 0;
     int num_chars = IMAGE_FONT_MULTIBYTE_JAPANESE_MAX_CHARS;
@@ -649,6 +910,7 @@ static int load_japanese_fonts(void)
     offset = parse_multibyte_font(num_half_width, &input, &pixels[offset], offset, 20, -9, num_chars*2);
     offset = parse_multibyte_font(num_full_width, &input, &pixels[offset], offset, 20, 1, num_chars*2 + num_half_width);
     log_info("Done parsing Japanese font", 0, offset);
+    io_close_file_view(&view);
 
     data.fonts_enabled = MULTIBYTE_IN_FONT;
     data.font_base_offset = 0;
@@ -680,25 +942,24 @@ int image_load_enemy(int enemy_id)
     const char *filename_bmp = ENEMY_GRAPHICS_555[enemy_id];
     const char *filename_idx = ENEMY_GRAPHICS_SG2[enemy_id];
 
-    if (ENEMY_INDEX_SIZE != io_read_file_part_into_buffer(
-        filename_idx, MAY_BE_LOCALIZED, data.tmp_data, ENEMY_INDEX_SIZE, ENEMY_INDEX_OFFSET)) {
+    io_file_view index;
+    buffer buf;
+    if (!open_index_file(filename_idx, &index, &buf, ENEMY_INDEX_OFFSET, ENEMY_INDEX_SIZE)) {
         return 0;
     }
-
-    buffer buf;
-    buffer_init(&buf, data.tmp_data, ENEMY_INDEX_SIZE);
     read_index(&buf, data.enemy, ENEMY_ENTRIES);
+    io_close_file_view(&index);
 
-    int data_size = io_read_file_into_buffer(filename_bmp, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
+    io_file_view view;
+    if (!open_graphics_file(filename_bmp, &view, &buf, SCRATCH_DATA_SIZE)) {
         return 0;
     }
-    buffer_init(&buf, data.tmp_data, data_size);
     convert_images(data.enemy, ENEMY_ENTRIES, &buf, data.enemy_data);
+    io_close_file_view(&view);
     return 1;
 }
 
-static const color_t *load_external_data(int image_id)
+static const color_t *load_external_data(int image_id, int *num_pixels)
 {
     image *img = &data.main[image_id];
     char filename[FILE_NAME_MAX] = "555/";
@@ -722,16 +983,76 @@ static const color_t *load_external_data(int image_id)
     }
     buffer buf;
     buffer_init(&buf, data.tmp_data, size);
-    color_t *dst = (color_t*) &data.tmp_data[4000000];
+    color_t *dst = (color_t*) &data.tmp_data[EXTERNAL_SCRATCH_OFFSET];
     // NB: isometric images are never external
     if (img->draw.is_fully_compressed) {
-        convert_compressed(&buf, img->draw.data_length, dst);
+        *num_pixels = convert_compressed(&buf, img->draw.data_length, dst);
     } else {
-        convert_uncompressed(&buf, img->draw.data_length, dst);
+        *num_pixels = convert_uncompressed(&buf, img->draw.data_length, dst);
     }
     return dst;
 }
 
+static const color_t *get_external_data(int image_id, unsigned int keep_used_after)
+{
+    int index = external_cache.entry_for_image[image_id];
+    if (index) {
+        external_cache_entry *entry = &external_cache.entries[index - 1];
+        entry->last_used = ++external_cache.use_counter;
+        return entry->pixels;
+    }
+    int num_pixels;
+    const color_t *pixels = load_external_data(image_id, &num_pixels);
+    if (!pixels) {
+        return NULL;
+    }
+    int size = num_pixels * sizeof(color_t);
+    if (!make_room_in_external_cache(size, keep_used_after)) {
+        return pixels;
+    }
+    color_t *cached_pixels = (color_t *) malloc(size);
+    if (!cached_pixels) {
+        return pixels;
+    }
+    memcpy(cached_pixels, pixels, size);
+    external_cache_entry *entry = &external_cache.entries[external_cache.num_entries++];
+    entry->image_id = image_id;
+    entry->size = size;
+    entry->last_used = ++external_cache.use_counter;
+    entry->pixels = cached_pixels;
+    external_cache.entry_for_image[image_id] = external_cache.num_entries;
+    external_cache.total_size += size;
+    return cached_pixels;
+}
+
+static int get_group_end(int group_start)
+{
+    int end = MAIN_ENTRIES;
+    for (int i = 0; i < MAX_GROUPS; i++) {
+        if (data.group_image_ids[i] > group_start && data.group_image_ids[i] < end) {
+            end = data.group_image_ids[i];
+        }
+    }
+    return end;
+}
+
+void image_prefetch_group(int group)
+{
+    int start = image_group(group);
+    int end = get_group_end(start);
+    unsigned int prefetch_start = external_cache.use_counter;
+    for (int id = start; id < end; id++) {
+        if (data.main[id].draw.is_external && id != image_group(GROUP_EMPIRE_MAP) &&
+            !external_cache.entry_for_image[id]) {
+            get_external_data(id, prefetch_start);
+            if (!external_cache.entry_for_image[id]) {
+                // the cache is full of images from this group
+                break;
+            }
+        }
+    }
+}
+
 int image_group(int group)
 {
     return data.group_image_ids[group];
@@ -778,7 +1099,7 @@ const color_t *image_data(int id)
     } else if (id == image_group(GROUP_EMPIRE_MAP)) {
         return data.empire_data;
     } else {
-        return load_external_data(id);
+        return get_external_data(id, UINT_MAX);
     }
 }
 
@@ -58,6 +58,12 @@ int image_init(void);
  */
 int image_load_climate(int climate_id, int is_editor, int force_reload);
 
+/**
+ * Gets the version of the climate images, which changes every time they are loaded
+ * @return Version of the climate images
+ */
+int image_climate_version(void);
+
 /**
  * Loads external fonts file (Cyrillic and Traditional Chinese)
  * @return boolean true on success, false on failure
@@ -71,6 +77,19 @@ int image_load_fonts(encoding_type encoding);
  */
 int image_load_enemy(int enemy_id);
 
+/**
+ * Sets how much memory decoded external images may keep, so they are not
+ * read from disk every time they are drawn
+ * @param max_bytes Maximum size of the cache, 0 disables it
+ */
+void image_set_external_cache_size(int max_bytes);
+
+/**
+ * Loads all external images of a group into the cache, as far as it fits
+ * @param group Image group
+ */
+void image_prefetch_group(int group);
+
 /**
  * Gets the image id of the first image in the group
  * @param group Image group
@@ -102,7 +121,8 @@ const image *image_get_enemy(int id);
 /**
  * Gets image pixel data by id
  * @param id Image ID
- * @return Pointer to data or null, short term use only.
+ * @return Pointer to data or null, short term use only: for external images,
+ *         it is valid until the next call for another external image
  */
 const color_t *image_data(int id);
 
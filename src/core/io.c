@@ -1,6 +1,7 @@
 #include "core/io.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "core/file.h"
 
@@ -43,6 +44,67 @@ int io_read_file_part_into_buffer(const char *filepath, int localizable, void *b
     return bytes_read;
 }
 
+static int read_file_view(const char *cased_file, io_file_view *view, void *buffer, int max_size)
+{
+    FILE *fp = file_open(cased_file, "rb");
+    if (!fp) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    if (size > max_size) {
+        size = max_size;
+    }
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *data = (uint8_t *) buffer;
+    if (!data && size > 0) {
+        data = (uint8_t *) malloc((size_t) size);
+        view->is_allocated = data != 0;
+    }
+    if (!data || size <= 0) {
+        file_close(fp);
+        return 0;
+    }
+    view->size = (int) fread(data, 1, (size_t) size, fp);
+    view->data = data;
+    file_close(fp);
+    return 1;
+}
+
+int io_open_file_view(const char *filepath, int localizable, io_file_view *view, void *buffer, int max_size)
+{
+    view->data = 0;
+    view->size = 0;
+    view->is_mapped = 0;
+    view->is_allocated = 0;
+    const char *cased_file = dir_get_file(filepath, localizable);
+    if (!cased_file) {
+        return 0;
+    }
+    int size;
+    view->data = (const uint8_t *) file_map(cased_file, &size);
+    if (view->data) {
+        view->is_mapped = 1;
+        view->mapped_size = size;
+        view->size = size < max_size ? size : max_size;
+        return 1;
+    }
+    return read_file_view(cased_file, view, buffer, max_size);
+}
+
+void io_close_file_view(io_file_view *view)
+{
+    if (view->is_mapped) {
+        file_unmap(view->data, view->mapped_size);
+    } else if (view->is_allocated) {
+        free((void *) view->data);
+    }
+    view->data = 0;
+    view->size = 0;
+    view->is_mapped = 0;
+    view->is_allocated = 0;
+}
+
 int io_write_buffer_to_file(const char *filepath, const void *buffer, int size)
 {
     // Find existing file to overwrite
@@ -3,11 +3,24 @@
 
 #include "core/dir.h"
 
+#include <stdint.h>
+
 /**
  * @file
  * I/O functions.
  */
 
+/**
+ * Read-only view of the contents of a file
+ */
+typedef struct {
+    const uint8_t *data; /**< Contents of the file */
+    int size; /**< Size of the file, at most the requested maximum */
+    int mapped_size; /**< Internal: size of the mapping */
+    int is_mapped; /**< Internal: whether the data is mapped */
+    int is_allocated; /**< Internal: whether the data is allocated */
+} io_file_view;
+
 /**
  * Reads the entire file into the buffer
  * @param filepath File to read
@@ -28,6 +41,25 @@ int io_read_file_into_buffer(const char *filepath, int localizable, void *buffer
  */
 int io_read_file_part_into_buffer(const char *filepath, int localizable, void *buffer, int size, int offset_in_file);
 
+/**
+ * Opens a read-only view of the file, limited to max_size bytes. The file is
+ * mapped into memory when the platform supports it, so nothing is copied,
+ * otherwise it is read into the buffer, or into allocated memory if no buffer is given.
+ * @param filepath File to open
+ * @param localizable Whether the file may be localized (see core/dir.h)
+ * @param view View to set up
+ * @param buffer Buffer of at least max_size bytes to read into when mapping is not possible, may be NULL
+ * @param max_size Max size of the view
+ * @return Boolean true on success, the view must then be closed with io_close_file_view
+ */
+int io_open_file_view(const char *filepath, int localizable, io_file_view *view, void *buffer, int max_size);
+
+/**
+ * Closes a view opened with io_open_file_view
+ * @param view View to close
+ */
+void io_close_file_view(io_file_view *view);
+
 /**
  * Writes the entire buffer to the file
  * @param filepath File to write
@@ -6,7 +6,6 @@
 #include "core/string.h"
 #include "translation/translation.h"
 
-#include <stdlib.h>
 #include <string.h>
 
 #define MAX_TEXT_ENTRIES 1000
@@ -72,16 +71,30 @@ static void parse_text(buffer *buf)
     buffer_read_raw(buf, data.text_data, MAX_TEXT_DATA);
 }
 
-static int load_text(const char *filename, int localizable, uint8_t *buf_data)
+static int open_file(const char *filename, int localizable, io_file_view *view)
 {
-    buffer buf;
-    int filesize = io_read_file_into_buffer(filename, localizable, buf_data, BUFFER_SIZE);
-    if (filesize < MIN_TEXT_SIZE || filesize > MAX_TEXT_SIZE) {
+    // files used to be read into a buffer of this size, anything after it was ignored
+    if (!io_open_file_view(filename, localizable, view, 0, BUFFER_SIZE)) {
         return 0;
     }
-    buffer_init(&buf, buf_data, filesize);
-    parse_text(&buf);
-    return 1;
+    return view->size;
+}
+
+static int load_text(const char *filename, int localizable)
+{
+    io_file_view view;
+    int filesize = open_file(filename, localizable, &view);
+    if (!filesize) {
+        return 0;
+    }
+    int success = filesize >= MIN_TEXT_SIZE && filesize <= MAX_TEXT_SIZE;
+    if (success) {
+        buffer buf;
+        buffer_init(&buf, (void *) view.data, filesize);
+        parse_text(&buf);
+    }
+    io_close_file_view(&view);
+    return success;
 }
 
 static uint8_t *get_message_text(int32_t offset)
@@ -127,27 +140,26 @@ static void parse_message(buffer *buf)
     buffer_read_raw(buf, &data.message_data, MAX_MESSAGE_DATA);
 }
 
-static int load_message(const char *filename, int localizable, uint8_t *data_buffer)
+static int load_message(const char *filename, int localizable)
 {
-    buffer buf;
-    int filesize = io_read_file_into_buffer(filename, localizable, data_buffer, BUFFER_SIZE);
-    if (filesize < MIN_MESSAGE_SIZE || filesize > MAX_MESSAGE_SIZE) {
+    io_file_view view;
+    int filesize = open_file(filename, localizable, &view);
+    if (!filesize) {
         return 0;
     }
-    buffer_init(&buf, data_buffer, filesize);
-    parse_message(&buf);
-    return 1;
+    int success = filesize >= MIN_MESSAGE_SIZE && filesize <= MAX_MESSAGE_SIZE;
+    if (success) {
+        buffer buf;
+        buffer_init(&buf, (void *) view.data, filesize);
+        parse_message(&buf);
+    }
+    io_close_file_view(&view);
+    return success;
 }
 
 static int load_files(const char *text_filename, const char *message_filename, int localizable)
 {
-    uint8_t *buffer = (uint8_t *) malloc(BUFFER_SIZE);
-    if (!buffer) {
-        return 0;
-    }
-    int success = load_text(text_filename, localizable, buffer) && load_message(message_filename, localizable, buffer);
-    free(buffer);
-    return success;
+    return load_text(text_filename, localizable) && load_message(message_filename, localizable);
 }
 
 int lang_load(int is_editor)
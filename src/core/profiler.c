@@ -0,0 +1,171 @@
+#include "core/profiler.h"
+
+#include "core/file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_SECTIONS 512
+#define HASH_SIZE 1024
+#define MAX_DEPTH 32
+
+typedef struct {
+    const char *name;
+    int index;
+    uint64_t ticks;
+    int calls;
+    double samples[PROFILER_SAMPLES];
+} section;
+
+static struct {
+    profiler_clock clock;
+    double ms_per_tick;
+    section sections[MAX_SECTIONS];
+    int num_sections;
+    int hash[HASH_SIZE];
+    struct {
+        int section_id;
+        uint64_t start;
+    } stack[MAX_DEPTH];
+    int depth;
+    int current_sample;
+    int frame;
+    FILE *csv;
+} data;
+
+void profiler_init(profiler_clock clock, uint64_t ticks_per_second)
+{
+    memset(&data, 0, sizeof(data));
+    data.clock = clock;
+    data.ms_per_tick = 1000.0 / ticks_per_second;
+}
+
+static int get_section_id(const char *name, int index)
+{
+    unsigned int hash = (unsigned int) (((uintptr_t) name >> 2) * 31 + index) % HASH_SIZE;
+    while (data.hash[hash]) {
+        int id = data.hash[hash] - 1;
+        if (data.sections[id].name == name && data.sections[id].index == index) {
+            return id;
+        }
+        hash = (hash + 1) % HASH_SIZE;
+    }
+    if (data.num_sections >= MAX_SECTIONS) {
+        return -1;
+    }
+    int id = data.num_sections++;
+    data.sections[id].name = name;
+    data.sections[id].index = index;
+    data.hash[hash] = id + 1;
+    return id;
+}
+
+void profiler_start(const char *name, int index)
+{
+    if (!data.clock || data.depth >= MAX_DEPTH) {
+        // still count the depth so the matching end is ignored
+        data.depth++;
+        return;
+    }
+    data.stack[data.depth].section_id = get_section_id(name, index);
+    data.stack[data.depth].start = data.clock();
+    data.depth++;
+}
+
+void profiler_end(void)
+{
+    if (data.depth <= 0) {
+        return;
+    }
+    data.depth--;
+    if (!data.clock || data.depth >= MAX_DEPTH) {
+        return;
+    }
+    int id = data.stack[data.depth].section_id;
+    if (id >= 0) {
+        data.sections[id].ticks += data.clock() - data.stack[data.depth].start;
+        data.sections[id].calls++;
+    }
+}
+
+static void write_csv_row(const section *s, double ms)
+{
+    if (s->index == PROFILER_NO_INDEX) {
+        fprintf(data.csv, "%d,\"%s\",,%d,%.4f\n", data.frame, s->name, s->calls, ms);
+    } else {
+        fprintf(data.csv, "%d,\"%s\",%d,%d,%.4f\n", data.frame, s->name, s->index, s->calls, ms);
+    }
+}
+
+void profiler_finish_sample(void)
+{
+    if (!data.clock) {
+        return;
+    }
+    for (int i = 0; i < data.num_sections; i++) {
+        section *s = &data.sections[i];
+        double ms = s->ticks * data.ms_per_tick;
+        s->samples[data.current_sample] = ms;
+        if (data.csv && s->calls) {
+            write_csv_row(s, ms);
+        }
+        s->ticks = 0;
+        s->calls = 0;
+    }
+    data.current_sample = (data.current_sample + 1) % PROFILER_SAMPLES;
+    data.frame++;
+}
+
+int profiler_get_top_sections(profiler_section_stats *stats, int max_sections)
+{
+    int count = 0;
+    for (int i = 0; i < data.num_sections; i++) {
+        const section *s = &data.sections[i];
+        double total = 0;
+        double max = 0;
+        for (int j = 0; j < PROFILER_SAMPLES; j++) {
+            total += s->samples[j];
+            if (s->samples[j] > max) {
+                max = s->samples[j];
+            }
+        }
+        double average = total / PROFILER_SAMPLES;
+        // insertion into the sorted list
+        int pos = count;
+        while (pos > 0 && stats[pos - 1].average_ms < average) {
+            if (pos < max_sections) {
+                stats[pos] = stats[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max_sections) {
+            stats[pos].name = s->name;
+            stats[pos].index = s->index;
+            stats[pos].average_ms = average;
+            stats[pos].max_ms = max;
+            if (count < max_sections) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+int profiler_start_csv(const char *filename)
+{
+    profiler_stop_csv();
+    data.csv = file_open(filename, "w");
+    if (!data.csv) {
+        return 0;
+    }
+    fprintf(data.csv, "frame,section,index,calls,ms\n");
+    return 1;
+}
+
+void profiler_stop_csv(void)
+{
+    if (data.csv) {
+        file_close(data.csv);
+        data.csv = 0;
+    }
+}
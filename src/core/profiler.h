@@ -0,0 +1,95 @@
+#ifndef CORE_PROFILER_H
+#define CORE_PROFILER_H
+
+#include <stdint.h>
+
+/**
+ * @file
+ * Built-in profiler for game ticks and drawing.
+ *
+ * Sections are only timed when the game is built with the PROFILER option,
+ * otherwise the macros below compile to the plain code.
+ * Timings are collected per sample (one frame) and averaged over the last
+ * PROFILER_SAMPLES samples.
+ */
+
+/**
+ * Number of samples the rolling averages are calculated over
+ */
+#define PROFILER_SAMPLES 60
+
+/**
+ * Index to use for sections that are not indexed
+ */
+#define PROFILER_NO_INDEX -1
+
+#ifdef PROFILER
+#define PROFILER_START(name) profiler_start(name, PROFILER_NO_INDEX)
+#define PROFILER_START_INDEXED(name, index) profiler_start(name, index)
+#define PROFILER_END() profiler_end()
+#define PROFILE(call) do { profiler_start(#call, PROFILER_NO_INDEX); call; profiler_end(); } while (0)
+#else
+#define PROFILER_START(name)
+#define PROFILER_START_INDEXED(name, index)
+#define PROFILER_END()
+#define PROFILE(call) call
+#endif
+
+typedef struct {
+    const char *name;
+    int index;
+    double average_ms;
+    double max_ms;
+} profiler_section_stats;
+
+/**
+ * Clock function: returns the current time in ticks of a high-resolution clock
+ */
+typedef uint64_t (*profiler_clock)(void);
+
+/**
+ * Enables the profiler. Nothing is timed before this is called.
+ * @param clock Clock to use
+ * @param ticks_per_second Clock ticks in one second
+ */
+void profiler_init(profiler_clock clock, uint64_t ticks_per_second);
+
+/**
+ * Starts timing a section. Sections may be nested.
+ * @param name Name of the section, must be a string constant
+ * @param index Index within the section, for example the figure type, or PROFILER_NO_INDEX
+ */
+void profiler_start(const char *name, int index);
+
+/**
+ * Stops timing the section that was started last
+ */
+void profiler_end(void);
+
+/**
+ * Finishes the current sample: stores the time spent in each section and
+ * writes it to the CSV file if one is open
+ */
+void profiler_finish_sample(void);
+
+/**
+ * Gets the sections with the highest rolling average time
+ * @param stats Array to store the statistics in
+ * @param max_sections Size of the array
+ * @return Number of sections stored, sorted by average time, highest first
+ */
+int profiler_get_top_sections(profiler_section_stats *stats, int max_sections);
+
+/**
+ * Starts writing the timings of every sample to a CSV file
+ * @param filename File to write to
+ * @return Boolean true on success
+ */
+int profiler_start_csv(const char *filename);
+
+/**
+ * Stops writing to the CSV file
+ */
+void profiler_stop_csv(void);
+
+#endif // CORE_PROFILER_H
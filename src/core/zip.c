@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "core/log.h"
+#include "core/thread.h"
 
 enum {
     PK_SUCCESS = 0,
@@ -16,6 +17,19 @@ enum {
     PK_EOF = 773,
 };
 
+#define PK_MAX_COPY_LENGTH 516
+#define PK_INPUT_SIZE 8708
+#define PK_END_OF_CHAIN 0xffff
+#define PK_NUM_LEVELS 7
+#define PK_LONGEST_LEVEL 16
+#define PK_LEVEL_HASH_BITS 13
+#define PK_LEVEL_HASH_SIZE (1 << PK_LEVEL_HASH_BITS)
+#define PK_LEVEL_CHAIN_SIZE 8192
+#define PK_CHAIN_STEPS_PER_BYTE 32
+#define PK_INITIAL_CHAIN_STEPS 16384
+#define PK_EXPLODE_BUFFER_SIZE 4096
+#define PK_HASH(data) ((data)[0] | (data)[1] << 8)
+
 struct pk_token {
     int stop;
 
@@ -45,32 +59,32 @@ struct pk_comp_buffer {
     uint8_t output_data[2050];
     int output_ptr;
 
-    uint16_t analyze_offset_table[2304];
-    uint16_t analyze_index[8708];
+    uint16_t hash_chain_start[0x10000];
+    uint16_t hash_chain_next[8708];
     signed short long_matcher[518];
 
+    int32_t level_head[PK_NUM_LEVELS * PK_LEVEL_HASH_SIZE];
+    uint16_t level_chain[PK_NUM_LEVELS][PK_LEVEL_CHAIN_SIZE];
+    int stream_offset;
+    int first_match_position;
+    int next_level_position;
+    int levels_initialized;
+    int use_levels;
+    int chain_steps_left;
+
     uint16_t codeword_values[774];
     uint8_t codeword_bits[774];
 };
 
-struct pk_decomp_buffer {
-    pk_input_func *input_func;
-    pk_output_func *output_func;
-    struct pk_token *token;
-
-    int window_size;
-    int dictionary_size;
-    uint16_t current_input_byte;
-    int current_input_bits_available;
-
-    int input_buffer_ptr;
-    int input_buffer_end;
-    int output_buffer_ptr;
-    uint8_t input_buffer[2048];
-    uint8_t output_buffer[8708]; // 2x 4096 (max dict size) + 516 for copying
+struct pk_explode_input {
+    const uint8_t *data;
+    int length;
 
-    uint8_t copy_offset_jump_table[256];
-    uint8_t copy_length_jump_table[256];
+    // only used when the compressed data is read in parts
+    zip_read_func read_func;
+    void *userdata;
+    int bytes_left;
+    uint8_t buffer[PK_EXPLODE_BUFFER_SIZE];
 };
 
 struct pk_copy_length_offset {
@@ -78,6 +92,9 @@ struct pk_copy_length_offset {
     uint16_t offset;
 };
 
+// compressing needs a lot of memory, so every thread keeps its buffer
+static THREAD_LOCAL struct pk_comp_buffer *comp_buffer;
+
 static const uint8_t pk_copy_offset_bits[64] = {
     2, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6,
     6, 6, 6, 6, 6, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
@@ -114,6 +131,8 @@ static const uint8_t pk_copy_length_extra_bits[16] = {
     0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8,
 };
 
+static const uint8_t pk_level_length[PK_NUM_LEVELS] = {2, 3, 4, 6, 8, 12, PK_LONGEST_LEVEL};
+
 static void pk_memcpy(uint8_t *dst, const uint8_t *src, int length)
 {
     for (int i = 0; i < length; i++) {
@@ -126,6 +145,13 @@ static void pk_memset(void *buffer, uint8_t fill_byte, unsigned int length)
     memset(buffer, fill_byte, length);
 }
 
+static uint64_t pk_read_little_endian(const uint8_t *data)
+{
+    // compilers turn this into a single load on little-endian machines
+    return (uint64_t) data[0] | (uint64_t) data[1] << 8 | (uint64_t) data[2] << 16 | (uint64_t) data[3] << 24 |
+        (uint64_t) data[4] << 32 | (uint64_t) data[5] << 40 | (uint64_t) data[6] << 48 | (uint64_t) data[7] << 56;
+}
+
 static int pk_implode_fill_input_buffer(struct pk_comp_buffer *buf, int bytes_to_read)
 {
     int used = 0;
@@ -192,115 +218,100 @@ static void pk_implode_write_copy_length_offset(struct pk_comp_buffer *buf, stru
     }
 }
 
-static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+static void pk_implode_extend_long_matcher(struct pk_comp_buffer *buf, int *long_index, short *long_offset,
+                                           const uint8_t *input_ptr, int length)
+{
+    do {
+        if (input_ptr[*long_index] != input_ptr[*long_offset]) {
+            *long_offset = buf->long_matcher[*long_offset];
+            if (*long_offset != -1) {
+                continue;
+            }
+        }
+        (*long_index)++;
+        (*long_offset)++;
+        buf->long_matcher[*long_index] = *long_offset;
+    } while (*long_index < length);
+}
+
+static void pk_implode_search_chain(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
 {
-    uint8_t *input_ptr = &buf->input_data[input_index];
-    int hash_value = 4 * input_ptr[0] + 5 * input_ptr[1];
-    uint16_t *analyze_offset_ptr = &buf->analyze_offset_table[hash_value];
-    uint16_t hash_analyze_index = *analyze_offset_ptr;
+    const uint8_t *input_ptr = &buf->input_data[input_index];
+    // the chain contains input_index itself, so walking it always ends before running out
+    uint16_t *chain_start = &buf->hash_chain_start[PK_HASH(input_ptr)];
     int min_match_index = input_index - buf->dictionary_size + 1;
-    uint16_t *analyze_index_ptr = &buf->analyze_index[hash_analyze_index];
-    if (*analyze_index_ptr < min_match_index) {
-        do {
-            analyze_index_ptr++;
-            hash_analyze_index++;
-        } while (*analyze_index_ptr < min_match_index);
-        *analyze_offset_ptr = hash_analyze_index;
+    while (*chain_start < min_match_index) {
+        *chain_start = buf->hash_chain_next[*chain_start];
     }
 
-    int max_matched_bytes = 1;
-    uint8_t *prev_input_ptr = input_ptr - 1;
-    uint16_t *hash_analyze_index_ptr = &buf->analyze_index[hash_analyze_index];
-    uint8_t *start_match = &buf->input_data[*hash_analyze_index_ptr];
-    if (prev_input_ptr <= start_match) {
+    int prev_input_index = input_index - 1;
+    int match_index = *chain_start;
+    if (match_index >= prev_input_index) {
         copy->length = 0;
         return;
     }
-    uint8_t *input_ptr_copy = input_ptr;
+    // all matches share the first two bytes, find the longest one, or the first one longer than 10 bytes
+    int max_matched_bytes = 1;
     while (1) {
-        if (start_match[max_matched_bytes - 1] == input_ptr_copy[max_matched_bytes - 1]
-            && *start_match == *input_ptr_copy) {
-            uint8_t *start_match_plus_one = start_match + 1;
-            uint8_t *input_ptr_copy_plus_one = input_ptr_copy + 1;
-            uint16_t matched_bytes = 2;
-            do {
-                start_match_plus_one++;
-                input_ptr_copy_plus_one++;
-                if (*start_match_plus_one != *input_ptr_copy_plus_one) {
-                    break;
-                }
+        const uint8_t *start_match = &buf->input_data[match_index];
+        if (start_match[max_matched_bytes - 1] == input_ptr[max_matched_bytes - 1]) {
+            int matched_bytes = 2;
+            while (matched_bytes < PK_MAX_COPY_LENGTH && start_match[matched_bytes] == input_ptr[matched_bytes]) {
                 matched_bytes++;
-            } while (matched_bytes < 516);
-            input_ptr_copy = input_ptr;
+            }
             if (matched_bytes >= max_matched_bytes) {
-                copy->offset = (uint16_t) (input_ptr - start_match_plus_one - 1 + matched_bytes);
+                copy->offset = (uint16_t) (input_index - match_index - 1);
                 max_matched_bytes = matched_bytes;
                 if (matched_bytes > 10) {
                     break;
                 }
             }
         }
-        hash_analyze_index_ptr++;
-        hash_analyze_index++;
-        start_match = &buf->input_data[*hash_analyze_index_ptr];
-        if (prev_input_ptr <= start_match) {
-            copy->length = (uint16_t) (max_matched_bytes < 2 ? 0 : max_matched_bytes);
+        match_index = buf->hash_chain_next[match_index];
+        buf->chain_steps_left--;
+        if (match_index >= prev_input_index) {
+            copy->length = max_matched_bytes < 2 ? 0 : max_matched_bytes;
             return;
         }
     }
-    if (max_matched_bytes == 516) {
-        copy->length = max_matched_bytes;
-        copy->offset--;
-        return;
-    }
-    if (&buf->input_data[buf->analyze_index[hash_analyze_index + 1]] >= prev_input_ptr) {
+    if (max_matched_bytes == PK_MAX_COPY_LENGTH || buf->hash_chain_next[match_index] >= prev_input_index) {
         copy->length = max_matched_bytes;
         return;
     }
-    // Complex algorithm for finding longer match
+    // Look for a longer match in the remaining part of the chain. The long matcher is the
+    // Knuth-Morris-Pratt failure table of the input, which tells which matches can be skipped.
     short long_offset = 0;
     int long_index = 1;
     buf->long_matcher[0] = -1;
     buf->long_matcher[1] = 0;
-    do {
-        if (input_ptr[long_index] != input_ptr[long_offset]) {
-            long_offset = buf->long_matcher[long_offset];
-            if (long_offset != -1) {
-                continue;
-            }
-        }
-        long_index++;
-        long_offset++;
-        buf->long_matcher[long_index] = long_offset;
-    } while (long_index < max_matched_bytes);
+    pk_implode_extend_long_matcher(buf, &long_index, &long_offset, input_ptr, max_matched_bytes);
     int matched_bytes = max_matched_bytes;
-    uint8_t *match_ptr = &buf->input_data[max_matched_bytes] + buf->analyze_index[hash_analyze_index];
+    const uint8_t *match_ptr = &buf->input_data[match_index + max_matched_bytes];
     while (1) {
         matched_bytes = buf->long_matcher[matched_bytes];
         if (matched_bytes == -1) {
             matched_bytes = 0;
         }
-        hash_analyze_index_ptr = &buf->analyze_index[hash_analyze_index];
-        uint8_t *better_match_ptr;
+        const uint8_t *better_match_ptr;
         do {
-            hash_analyze_index_ptr++;
-            hash_analyze_index++;
-            better_match_ptr = &buf->input_data[*hash_analyze_index_ptr];
-            if (better_match_ptr >= prev_input_ptr) {
+            match_index = buf->hash_chain_next[match_index];
+            buf->chain_steps_left--;
+            if (match_index >= prev_input_index) {
                 copy->length = max_matched_bytes;
                 return;
             }
+            better_match_ptr = &buf->input_data[match_index];
         } while (&better_match_ptr[matched_bytes] < match_ptr);
         if (input_ptr[max_matched_bytes - 2] != better_match_ptr[max_matched_bytes - 2]) {
             while (1) {
-                hash_analyze_index++;
-                better_match_ptr = &buf->input_data[buf->analyze_index[hash_analyze_index]];
-                if (better_match_ptr >= prev_input_ptr) {
+                match_index = buf->hash_chain_next[match_index];
+                buf->chain_steps_left--;
+                if (match_index >= prev_input_index) {
                     copy->length = max_matched_bytes;
                     return;
                 }
-                if (better_match_ptr[max_matched_bytes - 2] == input_ptr[max_matched_bytes - 2]
-                    && *better_match_ptr == *input_ptr) {
+                better_match_ptr = &buf->input_data[match_index];
+                if (better_match_ptr[max_matched_bytes - 2] == input_ptr[max_matched_bytes - 2]) {
                     matched_bytes = 2;
                     match_ptr = better_match_ptr + 2;
                     break;
@@ -308,38 +319,166 @@ static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_inde
             }
         } else if (&better_match_ptr[matched_bytes] != match_ptr) {
             matched_bytes = 0;
-            match_ptr = &buf->input_data[*hash_analyze_index_ptr];
+            match_ptr = better_match_ptr;
         }
         while (input_ptr[matched_bytes] == *match_ptr) {
             matched_bytes++;
-            if (matched_bytes >= 516) {
+            if (matched_bytes >= PK_MAX_COPY_LENGTH) {
                 break;
             }
             match_ptr++;
         }
         if (matched_bytes >= max_matched_bytes) {
-            copy->offset = (uint16_t) (input_ptr - better_match_ptr - 1);
+            copy->offset = (uint16_t) (input_index - match_index - 1);
+            if (matched_bytes > max_matched_bytes) {
+                max_matched_bytes = matched_bytes;
+                if (matched_bytes == PK_MAX_COPY_LENGTH) {
+                    copy->length = PK_MAX_COPY_LENGTH;
+                    return;
+                }
+                pk_implode_extend_long_matcher(buf, &long_index, &long_offset, input_ptr, matched_bytes);
+            }
+        }
+    }
+}
+
+static int pk_implode_match_length(const uint8_t *a, const uint8_t *b, int length)
+{
+    // compare 8 bytes at a time, the input buffer has room for reading past the maximum length
+    while (length + 8 <= PK_MAX_COPY_LENGTH) {
+        uint64_t x, y;
+        memcpy(&x, &a[length], 8);
+        memcpy(&y, &b[length], 8);
+        if (x != y) {
+            break;
+        }
+        length += 8;
+    }
+    while (length < PK_MAX_COPY_LENGTH && a[length] == b[length]) {
+        length++;
+    }
+    return length;
+}
+
+static void pk_implode_level_hashes(const uint8_t *data, unsigned int *hashes)
+{
+    // the input buffer has room for reading the longest level past any searched position
+    uint64_t low = pk_read_little_endian(data);
+    uint64_t high = pk_read_little_endian(&data[8]);
+    for (int level = 0; level < PK_NUM_LEVELS; level++) {
+        int length = pk_level_length[level];
+        uint64_t hash;
+        if (length <= 8) {
+            hash = (low << (64 - 8 * length)) * 0x9e3779b97f4a7c15u;
+        } else {
+            hash = low * 0x9e3779b97f4a7c15u ^ (high << (128 - 8 * length)) * 0xc2b2ae3d27d4eb4fu;
+        }
+        hashes[level] = level * PK_LEVEL_HASH_SIZE + (unsigned int) (hash >> (64 - PK_LEVEL_HASH_BITS));
+    }
+}
+
+static void pk_implode_insert_into_levels(struct pk_comp_buffer *buf, int position)
+{
+    unsigned int hashes[PK_NUM_LEVELS];
+    pk_implode_level_hashes(&buf->input_data[position - buf->stream_offset], hashes);
+    for (int level = 0; level < PK_NUM_LEVELS; level++) {
+        int previous = buf->level_head[hashes[level]];
+        int distance = position - previous;
+        buf->level_chain[level][position & (PK_LEVEL_CHAIN_SIZE - 1)] =
+            (uint16_t) (previous >= 0 && distance < 4096 ? distance : 0);
+        buf->level_head[hashes[level]] = position;
+    }
+}
+
+static void pk_implode_find_oldest_longest_match(struct pk_comp_buffer *buf, int input_index,
+                                                 struct pk_copy_length_offset *copy)
+{
+    const uint8_t *input_ptr = &buf->input_data[input_index];
+    int match_index = buf->hash_chain_start[PK_HASH(input_ptr)];
+    while (input_ptr[PK_MAX_COPY_LENGTH - 1] != buf->input_data[match_index + PK_MAX_COPY_LENGTH - 1]
+        || pk_implode_match_length(&buf->input_data[match_index], input_ptr, 2) != PK_MAX_COPY_LENGTH) {
+        match_index = buf->hash_chain_next[match_index];
+    }
+    copy->length = PK_MAX_COPY_LENGTH;
+    copy->offset = (uint16_t) (input_index - match_index - 1);
+}
+
+static void pk_implode_search_levels(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    const uint8_t *input_ptr = &buf->input_data[input_index];
+    int min_match_index = input_index - buf->dictionary_size + 1;
+    uint16_t *chain_start = &buf->hash_chain_start[PK_HASH(input_ptr)];
+    while (*chain_start < min_match_index) {
+        *chain_start = buf->hash_chain_next[*chain_start];
+    }
+    int position = input_index + buf->stream_offset;
+    while (buf->next_level_position < position - 1) {
+        pk_implode_insert_into_levels(buf, buf->next_level_position++);
+    }
+    int min_position = min_match_index + buf->stream_offset;
+    if (min_position < buf->first_match_position) {
+        min_position = buf->first_match_position;
+    }
+    unsigned int hashes[PK_NUM_LEVELS];
+    pk_implode_level_hashes(input_ptr, hashes);
+
+    // Walk from the most recent to the oldest match, using chains of longer matches
+    // as soon as a match is found, so that only matches longer than the current one are visited
+    int level = 0;
+    int node = buf->level_head[hashes[0]];
+    int max_matched_bytes = 0;
+    int match_position = position;
+    while (node >= min_position) {
+        if (node < match_position) {
+            int matched_bytes = pk_implode_match_length(&buf->input_data[node - buf->stream_offset], input_ptr, 0);
             if (matched_bytes > max_matched_bytes) {
                 max_matched_bytes = matched_bytes;
-                if (matched_bytes == 516) {
-                    copy->length = 516;
+                match_position = node;
+                if (matched_bytes == PK_MAX_COPY_LENGTH) {
+                    pk_implode_find_oldest_longest_match(buf, input_index, copy);
                     return;
                 }
-                do {
-                    if (input_ptr[long_index] != input_ptr[long_offset]) {
-                        long_offset = buf->long_matcher[long_offset];
-                        if (long_offset != -1) {
-                            continue;
-                        }
-                    }
-                    long_index++;
-                    long_offset++;
-                    buf->long_matcher[long_index] = long_offset;
-                } while (long_index < matched_bytes);
+                int next_level = level;
+                while (next_level + 1 < PK_NUM_LEVELS && pk_level_length[next_level + 1] <= matched_bytes + 1) {
+                    next_level++;
+                }
+                if (next_level != level) {
+                    level = next_level;
+                    node = buf->level_head[hashes[level]];
+                    continue;
+                }
             }
         }
+        int distance = buf->level_chain[level][node & (PK_LEVEL_CHAIN_SIZE - 1)];
+        if (!distance) {
+            break;
+        }
+        node -= distance;
+    }
+    copy->length = max_matched_bytes < 2 ? 0 : max_matched_bytes;
+    copy->offset = (uint16_t) (position - match_position - 1);
+}
+
+static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    if (buf->use_levels && input_index + PK_MAX_COPY_LENGTH <= PK_INPUT_SIZE) {
+        pk_implode_search_levels(buf, input_index, copy);
+        return;
+    }
+    pk_implode_search_chain(buf, input_index, copy);
+    if (buf->chain_steps_left < 0 && !buf->use_levels) {
+        // The chains are long for this data, switch to the level chains. Only positions
+        // that later searches can still match have to be added to them.
+        buf->use_levels = 1;
+        if (!buf->levels_initialized) {
+            memset(buf->level_head, 0xff, sizeof(buf->level_head));
+            buf->levels_initialized = 1;
+        }
+        int min_position = input_index - buf->dictionary_size + 1 + buf->stream_offset;
+        if (buf->next_level_position < min_position) {
+            buf->next_level_position = min_position;
+        }
     }
-    // never reached
 }
 
 static int pk_implode_next_copy_is_better(
@@ -358,21 +497,16 @@ static int pk_implode_next_copy_is_better(
 
 static void pk_implode_analyze_input(struct pk_comp_buffer *buf, int input_start, int input_end)
 {
-    memset(buf->analyze_offset_table, 0, sizeof(buf->analyze_offset_table));
+    // chains of positions with the same first two bytes, from the oldest to the newest
     for (int index = input_start; index < input_end; index++) {
-        buf->analyze_offset_table[4 * buf->input_data[index] + 5 * buf->input_data[index + 1]]++;
+        int hash = PK_HASH(&buf->input_data[index]);
+        buf->hash_chain_start[hash] = PK_END_OF_CHAIN;
     }
-
-    int running_total = 0;
-    for (int i = 0; i < 2304; i++) {
-        running_total += buf->analyze_offset_table[i];
-        buf->analyze_offset_table[i] = (uint16_t) running_total;
-    }
-
+    buf->first_match_position = input_start + buf->stream_offset;
     for (int index = input_end - 1; index >= input_start; index--) {
-        int hash_value = 4 * buf->input_data[index] + 5 * buf->input_data[index + 1];
-        unsigned short value = --buf->analyze_offset_table[hash_value];
-        buf->analyze_index[value] = (uint16_t) index;
+        uint16_t *chain_start = &buf->hash_chain_start[PK_HASH(&buf->input_data[index])];
+        buf->hash_chain_next[index] = *chain_start;
+        *chain_start = (uint16_t) index;
     }
 }
 
@@ -386,6 +520,9 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
     buf->output_ptr = 2;
 
     int input_ptr = buf->dictionary_size + 516;
+    buf->stream_offset = -input_ptr;
+    buf->next_level_position = 0;
+    buf->levels_initialized = 0;
     pk_memset(&buf->output_data[2], 0, 2048);
 
     buf->current_output_bits_used = 0;
@@ -416,6 +553,9 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
             pk_implode_analyze_input(buf, input_ptr - buf->dictionary_size, input_end + 1);
         }
 
+        // every block starts with the plain chains, which are fastest for most data
+        buf->use_levels = 0;
+        buf->chain_steps_left = PK_INITIAL_CHAIN_STEPS;
         while (input_ptr < input_end) {
             int write_literal = 0;
             int write_copy = 0;
@@ -444,16 +584,19 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
             if (write_copy) {
                 pk_implode_write_copy_length_offset(buf, copy);
                 input_ptr += copy.length;
+                buf->chain_steps_left += copy.length * PK_CHAIN_STEPS_PER_BYTE;
             } else if (write_literal) {
                 // Write literal
                 pk_implode_write_bits(buf, buf->codeword_bits[buf->input_data[input_ptr]],
                                       buf->codeword_values[buf->input_data[input_ptr]]);
                 input_ptr++;
+                buf->chain_steps_left += PK_CHAIN_STEPS_PER_BYTE;
             }
         }
 
         if (!eof) {
             input_ptr -= 4096;
+            buf->stream_offset += 4096;
             pk_memcpy(buf->input_data, &buf->input_data[4096], buf->dictionary_size + 516);
         }
     }
@@ -521,166 +664,165 @@ static void pk_explode_construct_jump_table(int size, const uint8_t *bits, const
     }
 }
 
-static int pk_explode_set_bits_used(struct pk_decomp_buffer *buf, int num_bits)
+static uint64_t pk_explode_peek_bits(const uint8_t *data, int data_length, int bit_position)
 {
-    if (buf->current_input_bits_available >= num_bits) {
-        buf->current_input_bits_available -= num_bits;
-        buf->current_input_byte = (uint16_t) (buf->current_input_byte >> num_bits);
-        return 0;
-    }
-    buf->current_input_byte = (uint16_t) (buf->current_input_byte >> buf->current_input_bits_available);
-    if (buf->input_buffer_ptr == buf->input_buffer_end) {
-        // Fill buffer
-        buf->input_buffer_ptr = 2048;
-        buf->input_buffer_end = buf->input_func(buf->input_buffer, buf->input_buffer_ptr, buf->token);
-        if (!buf->input_buffer_end) {
-            return 1;
+    // at least 56 bits are returned, bits past the end of the data are zero
+    int index = bit_position >> 3;
+    uint64_t bits;
+    if (index + 8 <= data_length) {
+        bits = pk_read_little_endian(&data[index]);
+    } else {
+        bits = 0;
+        for (int i = 0; index + i < data_length; i++) {
+            bits |= (uint64_t) data[index + i] << (8 * i);
         }
-        buf->input_buffer_ptr = 0;
     }
-
-    buf->current_input_byte |= (uint16_t) (buf->input_buffer[buf->input_buffer_ptr++] << 8);
-    buf->current_input_byte = (uint16_t) (buf->current_input_byte >> (num_bits - buf->current_input_bits_available));
-    buf->current_input_bits_available += 8 - num_bits;
-    return 0;
+    return bits >> (bit_position & 7);
 }
 
-static int pk_explode_decode_next_token(struct pk_decomp_buffer *buf)
+static void pk_explode_copy(uint8_t *output, int output_ptr, int offset, int length)
 {
-    if (buf->current_input_byte & 1) {
-        // copy
-        if (pk_explode_set_bits_used(buf, 1)) {
-            return PK_ERROR_VALUE;
-        }
-        int index = buf->copy_length_jump_table[buf->current_input_byte & 0xff];
-        if (pk_explode_set_bits_used(buf, pk_copy_length_base_bits[index])) {
-            return PK_ERROR_VALUE;
+    uint8_t *dst = &output[output_ptr];
+    if (offset > output_ptr) {
+        // the dictionary is empty at the start
+        int zeros = offset - output_ptr;
+        if (zeros > length) {
+            zeros = length;
         }
-        int extra_bits = pk_copy_length_extra_bits[index];
-        if (extra_bits) {
-            int extra_bits_value = buf->current_input_byte & ((1 << extra_bits) - 1);
-            if (pk_explode_set_bits_used(buf, extra_bits) && index + extra_bits_value != 270) {
-                return PK_ERROR_VALUE;
-            }
-            index = pk_copy_length_base_value[index] + extra_bits_value;
-        }
-        return index + 256;
-    } else {
-        // literal token
-        if (pk_explode_set_bits_used(buf, 1)) {
-            return PK_ERROR_VALUE;
-        }
-        int result = buf->current_input_byte & 0xff;
-        if (pk_explode_set_bits_used(buf, 8)) {
-            return PK_ERROR_VALUE;
-        }
-        return result;
+        memset(dst, 0, (size_t) zeros);
+        dst += zeros;
+        length -= zeros;
+    }
+    const uint8_t *src = dst - offset;
+    if (offset == 1) {
+        memset(dst, *src, (size_t) length);
+        return;
+    }
+    // the source may overlap the copied bytes, so copy at most offset bytes at a time
+    while (offset >= 8 && length >= 8) {
+        memcpy(dst, src, 8);
+        dst += 8;
+        src += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        *dst++ = *src++;
     }
 }
 
-static int pk_explode_get_copy_offset(struct pk_decomp_buffer *buf, int copy_length)
+static int pk_explode_fill(struct pk_explode_input *in, int min_bytes)
 {
-    int index = buf->copy_offset_jump_table[buf->current_input_byte & 0xff];
-    if (pk_explode_set_bits_used(buf, pk_copy_offset_bits[index])) {
-        return 0;
-    }
-    int offset;
-    if (copy_length == 2) {
-        offset = (buf->current_input_byte & 3) | (index << 2);
-        if (pk_explode_set_bits_used(buf, 2)) {
-            return 0;
+    while (in->length < min_bytes && in->bytes_left > 0) {
+        int length = PK_EXPLODE_BUFFER_SIZE - in->length;
+        if (length > in->bytes_left) {
+            length = in->bytes_left;
         }
-    } else {
-        offset = (buf->current_input_byte & buf->dictionary_size) | (index << buf->window_size);
-        if (pk_explode_set_bits_used(buf, buf->window_size)) {
+        int bytes_read = in->read_func(&in->buffer[in->length], length, in->userdata);
+        if (bytes_read <= 0 || bytes_read > length) {
             return 0;
         }
+        in->length += bytes_read;
+        in->bytes_left -= bytes_read;
     }
-    return offset + 1;
+    return 1;
 }
 
-static int pk_explode_data(struct pk_decomp_buffer *buf)
+static int pk_explode_refill(struct pk_explode_input *in, int *bit_position, int *max_bit_position)
 {
-    int token;
-    buf->output_buffer_ptr = 4096;
-    while (1) {
-        token = pk_explode_decode_next_token(buf);
-        if (token >= PK_ERROR_VALUE - 1) {
-            break;
-        }
-        if (token >= 256) {
-            // copy offset
-            int length = token - 254;
-            int offset = pk_explode_get_copy_offset(buf, length);
-            if (!offset) {
-                token = PK_ERROR_VALUE;
-                break;
-            }
-            uint8_t *src = &buf->output_buffer[buf->output_buffer_ptr - offset];
-            uint8_t *dst = &buf->output_buffer[buf->output_buffer_ptr];
-            buf->output_buffer_ptr += length;
-            do {
-                *dst = *src;
-                src++;
-                dst++;
-            } while (--length > 0);
-        } else {
-            // literal byte
-            buf->output_buffer[buf->output_buffer_ptr++] = (uint8_t) token;
-        }
-        if (buf->output_buffer_ptr >= 8192) {
-            // Flush buffer
-            buf->output_func(&buf->output_buffer[4096], 4096, buf->token);
-            pk_memcpy(buf->output_buffer, &buf->output_buffer[4096], buf->output_buffer_ptr - 4096);
-            buf->output_buffer_ptr -= 4096;
-        }
-    }
-    int remaining_bytes = buf->output_buffer_ptr - 4096;
-    if (remaining_bytes > 0) {
-        // Flush buffer if needed
-        buf->output_func(&buf->output_buffer[4096], remaining_bytes, buf->token);
-    }
-    return token;
+    // moves the unread bytes to the start of the buffer and reads more behind them
+    int consumed = *bit_position >> 3;
+    in->length -= consumed;
+    memmove(in->buffer, &in->data[consumed], (size_t) in->length);
+    in->data = in->buffer;
+    *bit_position -= 8 * consumed;
+    *max_bit_position -= 8 * consumed;
+    return pk_explode_fill(in, PK_EXPLODE_BUFFER_SIZE);
 }
 
-static int pk_explode(pk_input_func *input_func, pk_output_func *output_func,
-                      struct pk_decomp_buffer *buf, struct pk_token *token)
+static int pk_explode(struct pk_explode_input *in, int input_length, uint8_t *output, int *output_length)
 {
-    buf->input_func = input_func;
-    buf->output_func = output_func;
-    buf->token = token;
-    buf->input_buffer_ptr = 2048;
-    int bytes_read = buf->input_func(buf->input_buffer, buf->input_buffer_ptr, buf->token);
-    buf->input_buffer_end = bytes_read;
-    if (bytes_read <= 4) {
+    if (input_length <= 4) {
         return PK_TOO_FEW_INPUT_BYTES;
     }
-    int has_literal_encoding = buf->input_buffer[0];
-    buf->window_size = buf->input_buffer[1];
-    buf->current_input_byte = buf->input_buffer[2];
-    buf->current_input_bits_available = 0;
-    buf->input_buffer_ptr = 3;
-
-    if (buf->window_size < 4 || buf->window_size > 6) {
+    if (!pk_explode_fill(in, 2)) {
+        return PK_ERROR_DECODING;
+    }
+    int has_literal_encoding = in->data[0];
+    int window_size = in->data[1];
+    if (window_size < 4 || window_size > 6) {
         return PK_INVALID_WINDOWSIZE;
     }
-
-    buf->dictionary_size = 0xFFFF >> (16 - buf->window_size);
     if (has_literal_encoding) {
         return PK_LITERAL_ENCODING_UNSUPPORTED;
     }
-
-    // Decode data for copying bytes
-    pk_explode_construct_jump_table(16,
-        pk_copy_length_base_bits, pk_copy_length_base_code, buf->copy_length_jump_table);
-    pk_explode_construct_jump_table(64,
-        pk_copy_offset_bits, pk_copy_offset_code, buf->copy_offset_jump_table);
-
-    int result = pk_explode_data(buf);
-    if (result != PK_EOF) {
-        return PK_ERROR_DECODING;
+    uint8_t copy_length_jump_table[256];
+    uint8_t copy_offset_jump_table[256];
+    pk_explode_construct_jump_table(16, pk_copy_length_base_bits, pk_copy_length_base_code, copy_length_jump_table);
+    pk_explode_construct_jump_table(64, pk_copy_offset_bits, pk_copy_offset_code, copy_offset_jump_table);
+    unsigned int offset_extra_mask = 0xffff >> (16 - window_size);
+
+    // The original decoder always keeps the next 8 bits of the data loaded,
+    // so decoding fails as soon as fewer than 8 bits are left after a token
+    in->data += 2;
+    in->length -= 2;
+    int max_bit_position = 8 * (input_length - 3);
+    int bit_position = 0;
+    int output_ptr = 0;
+    while (1) {
+        if ((bit_position >> 3) + 8 > in->length && in->bytes_left > 0) {
+            if (!pk_explode_refill(in, &bit_position, &max_bit_position)) {
+                return PK_ERROR_DECODING;
+            }
+        }
+        uint64_t bits = pk_explode_peek_bits(in->data, in->length, bit_position);
+        if (!(bits & 1)) {
+            bit_position += 9;
+            if (bit_position > max_bit_position || output_ptr >= *output_length) {
+                return PK_ERROR_DECODING;
+            }
+            output[output_ptr++] = (uint8_t) (bits >> 1);
+            continue;
+        }
+        int index = copy_length_jump_table[(bits >> 1) & 0xff];
+        int used_bits = 1 + pk_copy_length_base_bits[index];
+        if (bit_position + used_bits > max_bit_position) {
+            return PK_ERROR_DECODING;
+        }
+        int length = index;
+        int extra_bits = pk_copy_length_extra_bits[index];
+        if (extra_bits) {
+            int extra_bits_value = (int) (bits >> used_bits) & ((1 << extra_bits) - 1);
+            used_bits += extra_bits;
+            length = pk_copy_length_base_value[index] + extra_bits_value;
+            if (length + 256 == PK_EOF) {
+                // the end marker may use bits that are not in the data
+                *output_length = output_ptr;
+                return PK_SUCCESS;
+            }
+            if (bit_position + used_bits > max_bit_position) {
+                return PK_ERROR_DECODING;
+            }
+        }
+        length += 2;
+        bits >>= used_bits;
+        int offset_index = copy_offset_jump_table[bits & 0xff];
+        int offset_bits = pk_copy_offset_bits[offset_index];
+        bits >>= offset_bits;
+        int offset;
+        if (length == 2) {
+            offset = (int) (bits & 3) | offset_index << 2;
+            used_bits += offset_bits + 2;
+        } else {
+            offset = (int) (bits & offset_extra_mask) | offset_index << window_size;
+            used_bits += offset_bits + window_size;
+        }
+        bit_position += used_bits;
+        if (bit_position > max_bit_position || length > *output_length - output_ptr) {
+            return PK_ERROR_DECODING;
+        }
+        pk_explode_copy(output, output_ptr, offset + 1, length);
+        output_ptr += length;
     }
-    return PK_SUCCESS;
 }
 
 static int zip_input_func(uint8_t *buffer, int length, struct pk_token *token)
@@ -720,17 +862,37 @@ static void zip_output_func(uint8_t *buffer, int length, struct pk_token *token)
     }
 }
 
+static struct pk_comp_buffer *get_comp_buffer(void)
+{
+    if (!comp_buffer) {
+        comp_buffer = (struct pk_comp_buffer *) malloc(sizeof(struct pk_comp_buffer));
+        if (!comp_buffer) {
+            return 0;
+        }
+        memset(comp_buffer, 0, sizeof(struct pk_comp_buffer));
+    } else {
+        // the compressor reads a few bytes past the data near the end, like the original one
+        memset(comp_buffer->input_data, 0, sizeof(comp_buffer->input_data));
+        memset(comp_buffer->output_data, 0, sizeof(comp_buffer->output_data));
+    }
+    return comp_buffer;
+}
+
+void zip_free_thread_buffers(void)
+{
+    free(comp_buffer);
+    comp_buffer = 0;
+}
+
 int zip_compress(const void *input_buffer, int input_length,
                  void *output_buffer, int *output_length)
 {
-    struct pk_token token;
-    struct pk_comp_buffer *buf = (struct pk_comp_buffer *) malloc(sizeof(struct pk_comp_buffer));
-
+    struct pk_comp_buffer *buf = get_comp_buffer();
     if (!buf) {
         return 0;
     }
 
-    memset(buf, 0, sizeof(struct pk_comp_buffer));
+    struct pk_token token;
     memset(&token, 0, sizeof(struct pk_token));
     token.input_data = (const uint8_t *) input_buffer;
     token.input_length = input_length;
@@ -745,33 +907,35 @@ int zip_compress(const void *input_buffer, int input_length,
     } else {
         *output_length = token.output_ptr;
     }
-    free(buf);
     return ok;
 }
 
 int zip_decompress(const void *input_buffer, int input_length,
                    void *output_buffer, int *output_length)
 {
-    struct pk_token token;
-    struct pk_decomp_buffer *buf = (struct pk_decomp_buffer *) malloc(sizeof(struct pk_decomp_buffer));
-    if (!buf) {
+    struct pk_explode_input in;
+    in.data = (const uint8_t *) input_buffer;
+    in.length = input_length;
+    in.bytes_left = 0;
+    if (pk_explode(&in, input_length, (uint8_t *) output_buffer, output_length)) {
+        log_error("COMP Error uncompressing.", 0, 0);
         return 0;
     }
-    memset(buf, 0, sizeof(struct pk_decomp_buffer));
-    memset(&token, 0, sizeof(struct pk_token));
-    token.input_data = (const uint8_t *) input_buffer;
-    token.input_length = input_length;
-    token.output_data = (uint8_t *) output_buffer;
-    token.output_length = *output_length;
+    return 1;
+}
 
-    int ok = 1;
-    int pk_error = pk_explode(zip_input_func, zip_output_func, buf, &token);
-    if (pk_error || token.stop) {
+int zip_decompress_stream(zip_read_func read_func, void *userdata, int input_length,
+                          void *output_buffer, int *output_length)
+{
+    struct pk_explode_input in;
+    in.data = in.buffer;
+    in.length = 0;
+    in.bytes_left = input_length;
+    in.read_func = read_func;
+    in.userdata = userdata;
+    if (pk_explode(&in, input_length, (uint8_t *) output_buffer, output_length)) {
         log_error("COMP Error uncompressing.", 0, 0);
-        ok = 0;
-    } else {
-        *output_length = token.output_ptr;
+        return 0;
     }
-    free(buf);
-    return ok;
+    return 1;
 }
@@ -6,6 +6,15 @@
  * Compression functions.
  */
 
+/**
+ * Function that provides compressed data to zip_decompress_stream
+ * @param buffer Buffer to read the data to
+ * @param length Maximum number of bytes to read
+ * @param userdata Userdata passed to zip_decompress_stream
+ * @return Number of bytes read, 0 on error
+ */
+typedef int (*zip_read_func)(void *buffer, int length, void *userdata);
+
 /**
  * Compresses the input buffer.
  * @param input_buffer Input buffer to compress
@@ -26,4 +35,22 @@ int zip_compress(const void *input_buffer, int input_length, void *output_buffer
  */
 int zip_decompress(const void *input_buffer, int input_length, void *output_buffer, int *output_length);
 
+/**
+ * Decompresses data that is read in small parts, directly into the output buffer
+ * @param read_func Function that reads the compressed data
+ * @param userdata Userdata for the read function
+ * @param input_length Length of the compressed data
+ * @param output_buffer Output buffer to write decompressed data to
+ * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @return boolean true on success, false on error
+ */
+int zip_decompress_stream(zip_read_func read_func, void *userdata, int input_length,
+                          void *output_buffer, int *output_length);
+
+/**
+ * Frees the buffers that zip_compress keeps for the calling thread.
+ * Must be called before a thread that compressed data exits.
+ */
+void zip_free_thread_buffers(void);
+
 #endif // CORE_ZIP_H
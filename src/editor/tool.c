@@ -295,7 +295,7 @@ void editor_tool_update_use(const map_tile *tile)
     }
 
     scenario_editor_updated_terrain();
-    widget_minimap_invalidate();
+    widget_minimap_update();
 }
 
 static void place_earthquake_flag(const map_tile *tile)
@@ -2,6 +2,7 @@
 
 #include "city/entertainment.h"
 #include "city/figures.h"
+#include "core/profiler.h"
 #include "figure/figure.h"
 #include "figuretype/animal.h"
 #include "figuretype/cartpusher.h"
@@ -112,7 +113,7 @@ void figure_action_handle(void)
 {
     city_figures_reset();
     city_entertainment_set_hippodrome_has_race(0);
-    for (int i = 1; i < MAX_FIGURES; i++) {
+    for (int i = 1; i < figure_count(); i++) {
         figure *f = figure_get(i);
         if (f->state) {
             if (f->targeted_by_figure_id) {
@@ -124,7 +125,9 @@ void figure_action_handle(void)
                     f->targeted_by_figure_id = 0;
                 }
             }
+            PROFILER_START_INDEXED("figure type", f->type);
             figure_action_callbacks[f->type](f);
+            PROFILER_END();
             if (f->state == FIGURE_STATE_DEAD) {
                 figure_delete(f);
             }
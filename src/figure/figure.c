@@ -2,6 +2,7 @@
 
 #include "building/building.h"
 #include "city/emperor.h"
+#include "core/config.h"
 #include "core/random.h"
 #include "empire/city.h"
 #include "figure/name.h"
@@ -10,31 +11,98 @@
 #include "map/figure.h"
 #include "map/grid.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#define FIGURE_BLOCK_SHIFT 10
+#define FIGURE_BLOCK_SIZE (1 << FIGURE_BLOCK_SHIFT)
+#define FIGURE_BLOCK_MASK (FIGURE_BLOCK_SIZE - 1)
+#define MAX_FIGURE_BLOCKS ((MAX_FIGURES + FIGURE_BLOCK_SIZE - 1) / FIGURE_BLOCK_SIZE)
+
+static figure original_figures[FIGURE_BLOCK_SIZE];
+
+// Figures are allocated in blocks so that pointers to them stay valid when the array grows
 static struct {
     int created_sequence;
-    figure figures[MAX_FIGURES];
-} data = {0};
+    figure *blocks[MAX_FIGURE_BLOCKS];
+    int num_blocks;
+    int size;
+} data = {0, {original_figures}, 1, ORIGINAL_MAX_FIGURES};
 
 figure *figure_get(int id)
 {
-    return &data.figures[id];
+    return &data.blocks[id >> FIGURE_BLOCK_SHIFT][id & FIGURE_BLOCK_MASK];
+}
+
+int figure_count(void)
+{
+    return data.size;
+}
+
+static int ensure_capacity(int size)
+{
+    int blocks_needed = (size + FIGURE_BLOCK_SIZE - 1) / FIGURE_BLOCK_SIZE;
+    if (blocks_needed > MAX_FIGURE_BLOCKS) {
+        return 0;
+    }
+    while (data.num_blocks < blocks_needed) {
+        figure *block = (figure *) calloc(FIGURE_BLOCK_SIZE, sizeof(figure));
+        if (!block) {
+            return 0;
+        }
+        int first_id = data.num_blocks * FIGURE_BLOCK_SIZE;
+        for (int i = 0; i < FIGURE_BLOCK_SIZE; i++) {
+            block[i].id = first_id + i;
+        }
+        data.blocks[data.num_blocks++] = block;
+    }
+    return 1;
+}
+
+int figure_reserve_slots(int count)
+{
+    return ensure_capacity(count);
+}
+
+static void clear_figures(int size)
+{
+    if (!ensure_capacity(size)) {
+        size = data.num_blocks * FIGURE_BLOCK_SIZE;
+    }
+    for (int b = 0; b < data.num_blocks; b++) {
+        figure *block = data.blocks[b];
+        memset(block, 0, FIGURE_BLOCK_SIZE * sizeof(figure));
+        for (int i = 0; i < FIGURE_BLOCK_SIZE; i++) {
+            block[i].id = b * FIGURE_BLOCK_SIZE + i;
+        }
+    }
+    data.size = size;
+}
+
+static int add_figure_slot(void)
+{
+    if (!config_get(CONFIG_GP_EXTEND_ENTITY_LIMITS) || data.size >= MAX_FIGURES || !ensure_capacity(data.size + 1)) {
+        return 0;
+    }
+    return data.size++;
 }
 
 figure *figure_create(figure_type type, int x, int y, direction_type dir)
 {
     int id = 0;
-    for (int i = 1; i < MAX_FIGURES; i++) {
-        if (!data.figures[i].state) {
+    for (int i = 1; i < data.size; i++) {
+        if (!figure_get(i)->state) {
             id = i;
             break;
         }
     }
     if (!id) {
-        return &data.figures[0];
+        id = add_figure_slot();
     }
-    figure *f = &data.figures[id];
+    if (!id) {
+        return figure_get(0);
+    }
+    figure *f = figure_get(id);
     f->state = FIGURE_STATE_ALIVE;
     f->faction_id = 1;
     f->type = type;
@@ -136,10 +204,7 @@ int figure_is_herd(const figure *f)
 
 void figure_init_scenario(void)
 {
-    for (int i = 0; i < MAX_FIGURES; i++) {
-        memset(&data.figures[i], 0, sizeof(figure));
-        data.figures[i].id = i;
-    }
+    clear_figures(ORIGINAL_MAX_FIGURES);
     data.created_sequence = 0;
 }
 
@@ -347,8 +412,8 @@ void figure_save_state(buffer *list, buffer *seq)
 {
     buffer_write_i32(seq, data.created_sequence);
 
-    for (int i = 0; i < MAX_FIGURES; i++) {
-        figure_save(list, &data.figures[i]);
+    for (int i = 0; i < data.size; i++) {
+        figure_save(list, figure_get(i));
     }
 }
 
@@ -356,8 +421,15 @@ void figure_load_state(buffer *list, buffer *seq)
 {
     data.created_sequence = buffer_read_i32(seq);
 
-    for (int i = 0; i < MAX_FIGURES; i++) {
-        figure_load(list, &data.figures[i]);
-        data.figures[i].id = i;
+    int size = list->size / FIGURE_STATE_SIZE;
+    if (size < ORIGINAL_MAX_FIGURES) {
+        size = ORIGINAL_MAX_FIGURES;
+    } else if (size > MAX_FIGURES) {
+        size = MAX_FIGURES;
+    }
+    clear_figures(size);
+    for (int i = 0; i < data.size; i++) {
+        figure_load(list, figure_get(i));
+        figure_get(i)->id = i;
     }
 }
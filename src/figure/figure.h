@@ -6,7 +6,20 @@
 #include "figure/action.h"
 #include "figure/type.h"
 
-#define MAX_FIGURES 1000
+/**
+ * Number of figure slots in the original game, a city always has at least this many slots
+ */
+#define ORIGINAL_MAX_FIGURES 1000
+
+/**
+ * Maximum number of figure slots a city can grow to
+ */
+#define MAX_FIGURES 30000
+
+/**
+ * Number of bytes a figure takes up in a saved game
+ */
+#define FIGURE_STATE_SIZE 128
 
 typedef struct {
     int id;
@@ -118,6 +131,19 @@ typedef struct {
 
 figure *figure_get(int id);
 
+/**
+ * Returns the number of figure slots, figure IDs range from 1 to figure_count() - 1
+ * @return Number of figure slots
+ */
+int figure_count(void);
+
+/**
+ * Allocates memory for the given number of figure slots, without adding them
+ * @param count Number of figure slots
+ * @return Boolean true if the memory is available, false otherwise
+ */
+int figure_reserve_slots(int count);
+
 /**
  * Creates a figure
  * @param type Figure type
@@ -1,34 +1,222 @@
 #include "route.h"
 
+#include "core/config.h"
+#include "map/grid.h"
 #include "map/routing.h"
 #include "map/routing_path.h"
 
-#define MAX_PATH_LENGTH 500
-#define MAX_ROUTES 600
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PATH_LENGTH (GRID_SIZE * GRID_SIZE)
+
+#define MIN_BLOCK_SHIFT 4
+#define NUM_BLOCK_CLASSES 12
+#define ARENA_SIZE 65536
+
+#define FREE_BITS_PER_WORD 32
+
+typedef struct {
+    uint8_t *directions;
+    int length;
+    int block_class;
+} route_path;
+
+typedef struct arena {
+    struct arena *next;
+} arena;
 
 static struct {
-    int figure_ids[MAX_ROUTES];
-    uint8_t direction_paths[MAX_ROUTES][MAX_PATH_LENGTH];
+    int *figure_ids;
+    route_path *paths;
+    uint32_t *free_slots;
+    int size;
+    int capacity;
+    uint8_t *free_blocks[NUM_BLOCK_CLASSES];
+    arena *arenas;
+    uint8_t path_buffer[MAX_PATH_LENGTH];
 } data;
 
+static int block_class_for(int length)
+{
+    int block_class = 0;
+    while ((1 << (MIN_BLOCK_SHIFT + block_class)) < length) {
+        block_class++;
+    }
+    return block_class;
+}
+
+static uint8_t *allocate_block(int block_class)
+{
+    if (!data.free_blocks[block_class]) {
+        // carve a new arena into blocks of this class and put them on the free list
+        int block_size = 1 << (MIN_BLOCK_SHIFT + block_class);
+        int arena_size = block_size > ARENA_SIZE ? block_size : ARENA_SIZE;
+        arena *new_arena = (arena *) malloc(sizeof(arena) + arena_size);
+        if (!new_arena) {
+            return 0;
+        }
+        new_arena->next = data.arenas;
+        data.arenas = new_arena;
+        uint8_t *blocks = (uint8_t *) (new_arena + 1);
+        for (int offset = arena_size - block_size; offset >= 0; offset -= block_size) {
+            uint8_t *block = &blocks[offset];
+            memcpy(block, &data.free_blocks[block_class], sizeof(uint8_t *));
+            data.free_blocks[block_class] = block;
+        }
+    }
+    uint8_t *block = data.free_blocks[block_class];
+    memcpy(&data.free_blocks[block_class], block, sizeof(uint8_t *));
+    return block;
+}
+
+static void free_block(uint8_t *block, int block_class)
+{
+    memcpy(block, &data.free_blocks[block_class], sizeof(uint8_t *));
+    data.free_blocks[block_class] = block;
+}
+
+static void free_all_blocks(void)
+{
+    while (data.arenas) {
+        arena *next = data.arenas->next;
+        free(data.arenas);
+        data.arenas = next;
+    }
+    memset(data.free_blocks, 0, sizeof(data.free_blocks));
+}
+
+static int reserve_path(route_path *path, int length)
+{
+    if (path->directions && length <= (1 << (MIN_BLOCK_SHIFT + path->block_class))) {
+        return 1;
+    }
+    int block_class = block_class_for(length);
+    uint8_t *directions = allocate_block(block_class);
+    if (!directions) {
+        return 0;
+    }
+    if (path->directions) {
+        memcpy(directions, path->directions, path->length);
+        free_block(path->directions, path->block_class);
+    }
+    path->directions = directions;
+    path->block_class = block_class;
+    return 1;
+}
+
+static int store_path(int path_id, const uint8_t *directions, int length)
+{
+    // directions beyond the new length are kept: they end up in the saved game just like in the original
+    route_path *path = &data.paths[path_id];
+    if (!reserve_path(path, length)) {
+        return 0;
+    }
+    memcpy(path->directions, directions, length);
+    if (length > path->length) {
+        path->length = length;
+    }
+    return 1;
+}
+
+static void set_figure_id(int path_id, int figure_id)
+{
+    data.figure_ids[path_id] = figure_id;
+    uint32_t bit = 1u << (path_id % FREE_BITS_PER_WORD);
+    if (figure_id) {
+        data.free_slots[path_id / FREE_BITS_PER_WORD] &= ~bit;
+    } else {
+        data.free_slots[path_id / FREE_BITS_PER_WORD] |= bit;
+    }
+}
+
+static int ensure_capacity(int size)
+{
+    if (size <= data.capacity) {
+        return 1;
+    }
+    int capacity = data.capacity ? data.capacity : ORIGINAL_MAX_ROUTES;
+    while (capacity < size) {
+        capacity += ORIGINAL_MAX_ROUTES;
+    }
+    if (capacity > MAX_FIGURE_ROUTES) {
+        capacity = MAX_FIGURE_ROUTES;
+    }
+    if (capacity < size) {
+        return 0;
+    }
+    int *figure_ids = (int *) realloc(data.figure_ids, capacity * sizeof(int));
+    if (!figure_ids) {
+        return 0;
+    }
+    data.figure_ids = figure_ids;
+    route_path *paths = (route_path *) realloc(data.paths, capacity * sizeof(route_path));
+    if (!paths) {
+        return 0;
+    }
+    data.paths = paths;
+    int words = (capacity + FREE_BITS_PER_WORD - 1) / FREE_BITS_PER_WORD;
+    uint32_t *free_slots = (uint32_t *) realloc(data.free_slots, words * sizeof(uint32_t));
+    if (!free_slots) {
+        return 0;
+    }
+    data.free_slots = free_slots;
+    memset(&data.paths[data.capacity], 0, (capacity - data.capacity) * sizeof(route_path));
+    for (int i = data.capacity; i < capacity; i++) {
+        set_figure_id(i, 0);
+    }
+    data.capacity = capacity;
+    return 1;
+}
+
+int figure_route_reserve_slots(int count)
+{
+    return ensure_capacity(count);
+}
+
+static void clear_routes(int size)
+{
+    if (!ensure_capacity(size)) {
+        size = data.capacity;
+    }
+    free_all_blocks();
+    memset(data.paths, 0, data.capacity * sizeof(route_path));
+    memset(data.free_slots, 0, (data.capacity + FREE_BITS_PER_WORD - 1) / FREE_BITS_PER_WORD * sizeof(uint32_t));
+    for (int i = 0; i < data.capacity; i++) {
+        set_figure_id(i, 0);
+    }
+    data.size = size;
+}
+
 void figure_route_clear_all(void)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
-        data.figure_ids[i] = 0;
-        for (int j = 0; j < MAX_PATH_LENGTH; j++) {
-            data.direction_paths[i][j] = 0;
+    clear_routes(ORIGINAL_MAX_ROUTES);
+}
+
+int figure_route_count(void)
+{
+    return data.size;
+}
+
+int figure_route_path_state_size(void)
+{
+    int state_size = ROUTE_PATH_STATE_SIZE;
+    for (int i = 0; i < data.size; i++) {
+        if (data.paths[i].length > state_size) {
+            state_size = data.paths[i].length;
         }
     }
+    return state_size;
 }
 
 void figure_route_clean(void)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
+    for (int i = 0; i < data.size; i++) {
         int figure_id = data.figure_ids[i];
-        if (figure_id > 0 && figure_id < MAX_FIGURES) {
+        if (figure_id > 0 && figure_id < figure_count()) {
             const figure *f = figure_get(figure_id);
             if (f->state != FIGURE_STATE_ALIVE || f->routing_path_id != i) {
-                data.figure_ids[i] = 0;
+                set_figure_id(i, 0);
             }
         }
     }
@@ -36,14 +224,39 @@ void figure_route_clean(void)
 
 static int get_first_available(void)
 {
-    for (int i = 1; i < MAX_ROUTES; i++) {
-        if (data.figure_ids[i] == 0) {
+    int words = (data.size + FREE_BITS_PER_WORD - 1) / FREE_BITS_PER_WORD;
+    for (int w = 0; w < words; w++) {
+        uint32_t bits = data.free_slots[w];
+        if (w == 0) {
+            bits &= ~1u; // route 0 is never used
+        }
+        if (!bits) {
+            continue;
+        }
+        int i = w * FREE_BITS_PER_WORD;
+        while (!(bits & 1)) {
+            bits >>= 1;
+            i++;
+        }
+        if (i < data.size) {
             return i;
         }
+        break;
+    }
+    if (config_get(CONFIG_GP_EXTEND_ENTITY_LIMITS) && data.size < MAX_FIGURE_ROUTES && ensure_capacity(data.size + 1)) {
+        return data.size++;
     }
     return 0;
 }
 
+static void release_unused_slot(int path_id)
+{
+    // a slot added for a route that could not be found is given back, so failed routes don't grow the table
+    if (path_id == data.size - 1 && data.size > ORIGINAL_MAX_ROUTES) {
+        data.size--;
+    }
+}
+
 void figure_route_add(figure *f)
 {
     f->routing_path_id = 0;
@@ -53,15 +266,16 @@ void figure_route_add(figure *f)
     if (!path_id) {
         return;
     }
+    int max_length = config_get(CONFIG_GP_EXTEND_ENTITY_LIMITS) ? MAX_PATH_LENGTH : ROUTE_PATH_STATE_SIZE;
     int path_length;
     if (f->is_boat) {
         if (f->is_boat == 2) { // flotsam
             map_routing_calculate_distances_water_flotsam(f->x, f->y);
-            path_length = map_routing_get_path_on_water(data.direction_paths[path_id],
+            path_length = map_routing_get_path_on_water(data.path_buffer, max_length,
                 f->destination_x, f->destination_y, 1);
         } else {
             map_routing_calculate_distances_water_boat(f->x, f->y);
-            path_length = map_routing_get_path_on_water(data.direction_paths[path_id],
+            path_length = map_routing_get_path_on_water(data.path_buffer, max_length,
                 f->destination_x, f->destination_y, 0);
         }
     } else {
@@ -107,24 +321,26 @@ void figure_route_add(figure *f)
         }
         if (can_travel) {
             if (f->terrain_usage == TERRAIN_USAGE_WALLS) {
-                path_length = map_routing_get_path(data.direction_paths[path_id], f->x, f->y,
+                path_length = map_routing_get_path(data.path_buffer, max_length, f->x, f->y,
                     f->destination_x, f->destination_y, 4);
                 if (path_length <= 0) {
-                    path_length = map_routing_get_path(data.direction_paths[path_id], f->x, f->y,
+                    path_length = map_routing_get_path(data.path_buffer, max_length, f->x, f->y,
                         f->destination_x, f->destination_y, 8);
                 }
             } else {
-                path_length = map_routing_get_path(data.direction_paths[path_id], f->x, f->y,
+                path_length = map_routing_get_path(data.path_buffer, max_length, f->x, f->y,
                     f->destination_x, f->destination_y, 8);
             }
         } else { // cannot travel
             path_length = 0;
         }
     }
-    if (path_length) {
-        data.figure_ids[path_id] = f->id;
+    if (path_length && store_path(path_id, data.path_buffer, path_length)) {
+        set_figure_id(path_id, f->id);
         f->routing_path_id = path_id;
         f->routing_path_length = path_length;
+    } else {
+        release_unused_slot(path_id);
     }
 }
 
@@ -132,7 +348,7 @@ void figure_route_remove(figure *f)
 {
     if (f->routing_path_id > 0) {
         if (data.figure_ids[f->routing_path_id] == f->id) {
-            data.figure_ids[f->routing_path_id] = 0;
+            set_figure_id(f->routing_path_id, 0);
         }
         f->routing_path_id = 0;
     }
@@ -140,21 +356,48 @@ void figure_route_remove(figure *f)
 
 int figure_route_get_direction(int path_id, int index)
 {
-    return data.direction_paths[path_id][index];
+    const route_path *path = &data.paths[path_id];
+    return index < path->length ? path->directions[index] : 0;
 }
 
 void figure_route_save_state(buffer *figures, buffer *paths)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
+    int state_size = paths->size / data.size;
+    for (int i = 0; i < data.size; i++) {
         buffer_write_i16(figures, data.figure_ids[i]);
-        buffer_write_raw(paths, data.direction_paths[i], MAX_PATH_LENGTH);
+        const route_path *path = &data.paths[i];
+        int length = path->length < state_size ? path->length : state_size;
+        if (length) {
+            buffer_write_raw(paths, path->directions, length);
+        }
+        for (int j = length; j < state_size; j++) {
+            buffer_write_u8(paths, 0);
+        }
     }
 }
 
 void figure_route_load_state(buffer *figures, buffer *paths)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
-        data.figure_ids[i] = buffer_read_i16(figures);
-        buffer_read_raw(paths, data.direction_paths[i], MAX_PATH_LENGTH);
+    int size = figures->size / 2;
+    if (size < ORIGINAL_MAX_ROUTES) {
+        size = ORIGINAL_MAX_ROUTES;
+    } else if (size > MAX_FIGURE_ROUTES) {
+        size = MAX_FIGURE_ROUTES;
+    }
+    clear_routes(size);
+    int state_size = paths->size / size;
+    for (int i = 0; i < data.size; i++) {
+        set_figure_id(i, buffer_read_i16(figures));
+        int length = buffer_read_raw(paths, data.path_buffer, state_size);
+        if (length < state_size) {
+            buffer_skip(paths, state_size - length);
+        }
+        // trailing zeros don't need to be stored: directions beyond the stored length read as zero
+        while (length > 0 && !data.path_buffer[length - 1]) {
+            length--;
+        }
+        if (length) {
+            store_path(i, data.path_buffer, length);
+        }
     }
 }
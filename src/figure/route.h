@@ -4,8 +4,44 @@
 #include "core/buffer.h"
 #include "figure/figure.h"
 
+/**
+ * Number of route slots in the original game, there are always at least this many slots
+ */
+#define ORIGINAL_MAX_ROUTES 600
+
+/**
+ * Maximum number of route slots, one for every figure
+ */
+#define MAX_FIGURE_ROUTES MAX_FIGURES
+
+/**
+ * Number of bytes the path of a route takes up in a saved game of the original game,
+ * routes are never longer than this unless entity limits are extended
+ */
+#define ROUTE_PATH_STATE_SIZE 500
+
 void figure_route_clear_all(void);
 
+/**
+ * Returns the number of route slots
+ * @return Number of route slots
+ */
+int figure_route_count(void);
+
+/**
+ * Allocates memory for the given number of route slots, without adding them
+ * @param count Number of route slots
+ * @return Boolean true if the memory is available, false otherwise
+ */
+int figure_route_reserve_slots(int count);
+
+/**
+ * Returns the number of bytes each route path needs in a saved game:
+ * the original size, or the length of the longest path if that is longer
+ * @return Number of bytes per route path
+ */
+int figure_route_path_state_size(void);
+
 void figure_route_clean(void);
 
 void figure_route_add(figure *f);
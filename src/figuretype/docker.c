@@ -90,9 +90,8 @@ static int get_closest_warehouse_for_import(int x, int y, int city_id, int dista
     }
     int min_distance = 10000;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE) {
+    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (!b->has_road_access || b->distance_from_entry <= 0) {
@@ -121,7 +120,7 @@ static int get_closest_warehouse_for_import(int x, int y, int city_id, int dista
                 distance += distance_penalty;
                 if (distance < min_distance) {
                     min_distance = distance;
-                    min_building_id = i;
+                    min_building_id = b->id;
                 }
             }
         }
@@ -156,9 +155,8 @@ static int get_closest_warehouse_for_export(int x, int y, int city_id, int dista
     }
     int min_distance = 10000;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE) {
+    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (!b->has_road_access || b->distance_from_entry <= 0) {
@@ -181,7 +179,7 @@ static int get_closest_warehouse_for_export(int x, int y, int city_id, int dista
             distance += distance_penalty;
             if (distance < min_distance) {
                 min_distance = distance;
-                min_building_id = i;
+                min_building_id = b->id;
             }
         }
     }
@@ -19,7 +19,7 @@ static int determine_destination(int x, int y, building_type type1, building_typ
 
     building_list_small_clear();
 
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
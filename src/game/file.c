@@ -359,11 +359,26 @@ int game_file_load_saved_game(const char *filename)
     return 1;
 }
 
+int game_file_read_saved_game_info(const char *filename, saved_game_info *info)
+{
+    return game_file_io_read_saved_game_info(filename, info);
+}
+
 int game_file_write_saved_game(const char *filename)
 {
     return game_file_io_write_saved_game(filename);
 }
 
+int game_file_write_saved_game_in_background(const char *filename)
+{
+    return game_file_io_write_saved_game_in_background(filename);
+}
+
+void game_file_finish_background_save(void)
+{
+    game_file_io_finish_background_save();
+}
+
 int game_file_delete_saved_game(const char *filename)
 {
     return game_file_io_delete_saved_game(filename);
@@ -1,6 +1,8 @@
 #ifndef GAME_FILE_H
 #define GAME_FILE_H
 
+#include "game/file_io.h"
+
 #include <stdint.h>
 
 /**
@@ -31,6 +33,14 @@ int game_file_load_scenario_data(const char *scenario_file);
  */
 int game_file_load_saved_game(const char *filename);
 
+/**
+ * Read the date, population and treasury of a saved game without loading it
+ * @param filename File to read
+ * @param info Info to fill
+ * @return Boolean true on success, false on failure
+ */
+int game_file_read_saved_game_info(const char *filename, saved_game_info *info);
+
 /**
  * Write saved game to disk
  * @param filename File to save to
@@ -38,6 +48,18 @@ int game_file_load_saved_game(const char *filename);
  */
 int game_file_write_saved_game(const char *filename);
 
+/**
+ * Write saved game to disk on a background thread
+ * @param filename File to save to
+ * @return Boolean true on success, false on failure
+ */
+int game_file_write_saved_game_in_background(const char *filename);
+
+/**
+ * Wait until the saved game written in the background is on disk
+ */
+void game_file_finish_background_save(void);
+
 /**
  * Delete saved game
  * @param filename File to delete
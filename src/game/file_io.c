@@ -1,6 +1,8 @@
 #include "file_io.h"
 
 #include "building/barracks.h"
+#include "building/building.h"
+#include "building/building_state.h"
 #include "building/count.h"
 #include "building/list.h"
 #include "building/storage.h"
@@ -10,6 +12,8 @@
 #include "core/log.h"
 #include "city/message.h"
 #include "city/view.h"
+#include "core/config.h"
+#include "core/deflate.h"
 #include "core/dir.h"
 #include "core/random.h"
 #include "core/zip.h"
@@ -22,6 +26,7 @@
 #include "figure/name.h"
 #include "figure/route.h"
 #include "figure/trader.h"
+#include "game/system.h"
 #include "game/time.h"
 #include "game/tutorial.h"
 #include "map/aqueduct.h"
@@ -30,6 +35,7 @@
 #include "map/desirability.h"
 #include "map/elevation.h"
 #include "map/figure.h"
+#include "map/grid.h"
 #include "map/image.h"
 #include "map/property.h"
 #include "map/random.h"
@@ -50,12 +56,48 @@
 
 #define COMPRESS_BUFFER_SIZE 600000
 #define UNCOMPRESSED 0x80000000
+#define MAX_SAVEGAME_PIECES 100
+
+// "JSVZ": saved game with the same pieces, but compressed with deflate instead of PKWare implode
+#define DEFLATE_SAVE_MAGIC 0x5a56534a
+#define DEFLATE_SAVE_CONTAINER_VERSION 1
 
 static const int SAVE_GAME_VERSION = 0x66;
+static const int SAVE_GAME_VERSION_DYNAMIC_COUNTS = 0x67;
 
-static char compress_buffer[COMPRESS_BUFFER_SIZE];
+static struct {
+    char *data;
+    int size;
+} compress_buffer;
 
 static int savegame_version;
+// 0 for the original format, otherwise the deflate compression level
+static int savegame_compression_level;
+
+enum {
+    PIECE_NOT_DONE = 0,
+    PIECE_COMPRESSED = 1,
+    PIECE_NOT_COMPRESSIBLE = 2,
+    PIECE_SKIPPED = 3
+};
+
+typedef struct {
+    int status;
+    int max_size;
+    char *data;
+    int size;
+} compressed_piece;
+
+static struct {
+    compressed_piece pieces[MAX_SAVEGAME_PIECES];
+    int order[MAX_SAVEGAME_PIECES];
+} compressed_pieces;
+
+static struct {
+    int running;
+    char filename[FILE_NAME_MAX];
+    char temp_filename[FILE_NAME_MAX];
+} background_save;
 
 typedef struct {
     buffer buf;
@@ -84,6 +126,7 @@ static struct {
 typedef struct {
     buffer *scenario_campaign_mission;
     buffer *file_version;
+    buffer *entity_counts;
     buffer *image_grid;
     buffer *edge_grid;
     buffer *building_grid;
@@ -169,7 +212,8 @@ typedef struct {
 
 static struct {
     int num_pieces;
-    file_piece pieces[100];
+    file_piece pieces[MAX_SAVEGAME_PIECES];
+    file_piece entity_counts;
     savegame_state state;
 } savegame_data = {0};
 
@@ -181,6 +225,22 @@ static void init_file_piece(file_piece *piece, int size, int compressed)
     buffer_init(&piece->buf, data, size);
 }
 
+static int resize_piece(buffer *buf, int size)
+{
+    if (buf->size == size) {
+        return 1;
+    }
+    void *data = realloc(buf->data, size);
+    if (!data) {
+        return 0;
+    }
+    if (size > buf->size) {
+        memset((uint8_t *) data + buf->size, 0, size - buf->size);
+    }
+    buffer_init(buf, data, size);
+    return 1;
+}
+
 static buffer *create_scenario_piece(int size)
 {
     file_piece *piece = &scenario_data.pieces[scenario_data.num_pieces++];
@@ -216,17 +276,31 @@ static void init_scenario_data(void)
     state->end_marker = create_scenario_piece(4);
 }
 
+static int resize_entity_pieces(int num_buildings, int num_figures, int num_routes, int route_path_size)
+{
+    savegame_state *state = &savegame_data.state;
+    return resize_piece(state->figures, num_figures * FIGURE_STATE_SIZE)
+        && resize_piece(state->route_figures, num_routes * 2)
+        && resize_piece(state->route_paths, num_routes * route_path_size)
+        && resize_piece(state->buildings, num_buildings * BUILDING_STATE_SIZE);
+}
+
 static void init_savegame_data(void)
 {
     if (savegame_data.num_pieces > 0) {
         for (int i = 0; i < savegame_data.num_pieces; i++) {
             buffer_reset(&savegame_data.pieces[i].buf);
         }
+        buffer_reset(&savegame_data.entity_counts.buf);
+        resize_entity_pieces(ORIGINAL_MAX_BUILDINGS, ORIGINAL_MAX_FIGURES, ORIGINAL_MAX_ROUTES, ROUTE_PATH_STATE_SIZE);
         return;
     }
     savegame_state *state = &savegame_data.state;
     state->scenario_campaign_mission = create_savegame_piece(4, 0);
     state->file_version = create_savegame_piece(4, 0);
+    // only present in saved games that exceed the entity or route length limits of the original game
+    init_file_piece(&savegame_data.entity_counts, 16, 0);
+    state->entity_counts = &savegame_data.entity_counts.buf;
     state->image_grid = create_savegame_piece(52488, 1);
     state->edge_grid = create_savegame_piece(26244, 1);
     state->building_grid = create_savegame_piece(52488, 1);
@@ -342,6 +416,11 @@ static void scenario_save_to_state(scenario_state *file)
     buffer_skip(file->end_marker, 4);
 }
 
+static int has_entity_counts(int version)
+{
+    return version >= SAVE_GAME_VERSION_DYNAMIC_COUNTS;
+}
+
 static void savegame_load_from_state(savegame_state *state)
 {
     savegame_version = buffer_read_i32(state->file_version);
@@ -426,6 +505,12 @@ static void savegame_load_from_state(savegame_state *state)
 static void savegame_save_to_state(savegame_state *state)
 {
     buffer_write_i32(state->file_version, savegame_version);
+    if (has_entity_counts(savegame_version)) {
+        buffer_write_i32(state->entity_counts, building_count());
+        buffer_write_i32(state->entity_counts, figure_count());
+        buffer_write_i32(state->entity_counts, figure_route_count());
+        buffer_write_i32(state->entity_counts, state->route_paths->size / figure_route_count());
+    }
 
     scenario_settings_save_state(state->scenario_campaign_mission,
                                  state->scenario_settings,
@@ -564,34 +649,100 @@ static void write_int32(FILE *fp, int value)
     fwrite(&data, 1, 4, fp);
 }
 
-static int read_compressed_chunk(FILE *fp, void *buffer, int bytes_to_read)
+static int ensure_compress_buffer(int size)
 {
-    if (bytes_to_read > COMPRESS_BUFFER_SIZE) {
+    if (size < COMPRESS_BUFFER_SIZE) {
+        size = COMPRESS_BUFFER_SIZE;
+    }
+    if (size <= compress_buffer.size) {
+        return 1;
+    }
+    char *data = (char *) realloc(compress_buffer.data, size);
+    if (!data) {
         return 0;
     }
+    compress_buffer.data = data;
+    compress_buffer.size = size;
+    return 1;
+}
+
+typedef struct {
+    FILE *fp;
+    int bytes_left;
+} chunk_reader;
+
+static int read_chunk_data(void *buffer, int length, void *userdata)
+{
+    chunk_reader *reader = (chunk_reader *) userdata;
+    if (length > reader->bytes_left) {
+        length = reader->bytes_left;
+    }
+    int bytes_read = (int) fread(buffer, 1, length, reader->fp);
+    reader->bytes_left -= bytes_read;
+    return bytes_read;
+}
+
+static int read_compressed_chunk(FILE *fp, void *buffer, int bytes_to_read, int deflated)
+{
     int input_size = read_int32(fp);
     if ((unsigned int) input_size == UNCOMPRESSED) {
-        if (fread(buffer, 1, bytes_to_read, fp) != bytes_to_read) {
-            return 0;
-        }
+        return fread(buffer, 1, bytes_to_read, fp) == bytes_to_read;
+    }
+    if (input_size < 0) {
+        return 0;
+    }
+    // decoded straight from the file, so no copy of the compressed data is needed
+    chunk_reader reader = { fp, input_size };
+    int result;
+    if (deflated) {
+        result = deflate_decompress(read_chunk_data, &reader, buffer, &bytes_to_read);
     } else {
-        if (fread(compress_buffer, 1, input_size, fp) != input_size
-            || !zip_decompress(compress_buffer, input_size, buffer, &bytes_to_read)) {
-            return 0;
+        result = zip_decompress_stream(read_chunk_data, &reader, input_size, buffer, &bytes_to_read);
+    }
+    if (!result) {
+        return 0;
+    }
+    // the decoders may stop before the end of the compressed data
+    return !reader.bytes_left || fseek(fp, reader.bytes_left, SEEK_CUR) == 0;
+}
+
+static int skip_piece(FILE *fp, const file_piece *piece)
+{
+    int size = piece->buf.size;
+    if (piece->compressed) {
+        int input_size = read_int32(fp);
+        if ((unsigned int) input_size != UNCOMPRESSED) {
+            if (input_size < 0) {
+                return 0;
+            }
+            size = input_size;
         }
     }
-    return 1;
+    return fseek(fp, size, SEEK_CUR) == 0;
+}
+
+static int max_compressed_size(int size)
+{
+    return savegame_compression_level ? deflate_max_compressed_size(size) : size;
+}
+
+static int compress_data(const void *buffer, int bytes_to_write, void *output, int *output_size)
+{
+    if (savegame_compression_level) {
+        return deflate_compress(buffer, bytes_to_write, output, output_size, savegame_compression_level);
+    }
+    return zip_compress(buffer, bytes_to_write, output, output_size);
 }
 
 static int write_compressed_chunk(FILE *fp, const void *buffer, int bytes_to_write)
 {
-    if (bytes_to_write > COMPRESS_BUFFER_SIZE) {
+    if (!ensure_compress_buffer(max_compressed_size(bytes_to_write))) {
         return 0;
     }
-    int output_size = COMPRESS_BUFFER_SIZE;
-    if (zip_compress(buffer, bytes_to_write, compress_buffer, &output_size)) {
+    int output_size = compress_buffer.size;
+    if (compress_data(buffer, bytes_to_write, compress_buffer.data, &output_size)) {
         write_int32(fp, output_size);
-        fwrite(compress_buffer, 1, output_size, fp);
+        fwrite(compress_buffer.data, 1, output_size, fp);
     } else {
         // unable to compress: write uncompressed
         write_int32(fp, UNCOMPRESSED);
@@ -600,13 +751,63 @@ static int write_compressed_chunk(FILE *fp, const void *buffer, int bytes_to_wri
     return 1;
 }
 
-static int savegame_read_from_file(FILE *fp)
+static int read_entity_counts(FILE *fp)
+{
+    buffer *buf = savegame_data.state.entity_counts;
+    if (fread(buf->data, 1, buf->size, fp) != buf->size) {
+        return 0;
+    }
+    int num_buildings = buffer_read_i32(buf);
+    int num_figures = buffer_read_i32(buf);
+    int num_routes = buffer_read_i32(buf);
+    int route_path_size = buffer_read_i32(buf);
+    if (num_buildings < ORIGINAL_MAX_BUILDINGS || num_buildings > MAX_BUILDINGS ||
+        num_figures < ORIGINAL_MAX_FIGURES || num_figures > MAX_FIGURES ||
+        num_routes < ORIGINAL_MAX_ROUTES || num_routes > MAX_FIGURE_ROUTES ||
+        route_path_size < ROUTE_PATH_STATE_SIZE || route_path_size > GRID_SIZE * GRID_SIZE) {
+        return 0;
+    }
+    return resize_entity_pieces(num_buildings, num_figures, num_routes, route_path_size);
+}
+
+static int reserve_entity_slots(const savegame_state *state)
+{
+    // the current game is only replaced when the tables of the saved game fit in memory
+    return building_reserve_slots(state->buildings->size / BUILDING_STATE_SIZE)
+        && figure_reserve_slots(state->figures->size / FIGURE_STATE_SIZE)
+        && figure_route_reserve_slots(state->route_figures->size / 2);
+}
+
+static int read_container_header(FILE *fp, int offset, int *deflated)
+{
+    *deflated = read_int32(fp) == DEFLATE_SAVE_MAGIC;
+    if (*deflated) {
+        return read_int32(fp) == DEFLATE_SAVE_CONTAINER_VERSION;
+    }
+    return fseek(fp, offset, SEEK_SET) == 0;
+}
+
+static int is_info_piece(const buffer *buf)
+{
+    const savegame_state *state = &savegame_data.state;
+    return buf == state->scenario_campaign_mission || buf == state->file_version || buf == state->city_data
+        || buf == state->game_time || buf == state->scenario_name;
+}
+
+static int savegame_read_from_file(FILE *fp, int offset, int info_only)
 {
+    int deflated;
+    if (!read_container_header(fp, offset, &deflated)) {
+        return 0;
+    }
     for (int i = 0; i < savegame_data.num_pieces; i++) {
         file_piece *piece = &savegame_data.pieces[i];
         int result = 0;
-        if (piece->compressed) {
-            result = read_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+        if (info_only && !is_info_piece(&piece->buf)) {
+            // the grids and entities are skipped without decoding them
+            result = skip_piece(fp, piece);
+        } else if (piece->compressed) {
+            result = read_compressed_chunk(fp, piece->buf.data, piece->buf.size, deflated);
         } else {
             result = fread(piece->buf.data, 1, piece->buf.size, fp) == piece->buf.size;
         }
@@ -614,24 +815,134 @@ static int savegame_read_from_file(FILE *fp)
         if (!result && i != (savegame_data.num_pieces - 1)) {
             return 0;
         }
+        if (&piece->buf == savegame_data.state.file_version) {
+            int version = buffer_read_i32(&piece->buf);
+            buffer_reset(&piece->buf);
+            if (has_entity_counts(version) && !read_entity_counts(fp)) {
+                return 0;
+            }
+        }
+        if (info_only && &piece->buf == savegame_data.state.scenario_name) {
+            // the rest of the file is not needed for the info
+            break;
+        }
     }
     return 1;
 }
 
-static void savegame_write_to_file(FILE *fp)
+static void compress_piece_task(int task_id, void *userdata)
 {
+    compressed_piece *compressed = &compressed_pieces.pieces[compressed_pieces.order[task_id]];
+    const file_piece *piece = &savegame_data.pieces[compressed_pieces.order[task_id]];
+    char *data = (char *) malloc(compressed->max_size);
+    if (!data) {
+        return;
+    }
+    int output_size = compressed->max_size;
+    if (compress_data(piece->buf.data, piece->buf.size, data, &output_size)) {
+        char *shrunk = (char *) realloc(data, output_size ? output_size : 1);
+        compressed->data = shrunk ? shrunk : data;
+        compressed->size = output_size;
+        compressed->status = PIECE_COMPRESSED;
+    } else {
+        free(data);
+        compressed->status = PIECE_NOT_COMPRESSIBLE;
+    }
+}
+
+static void compress_pieces(int in_parallel)
+{
+    int num_tasks = 0;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        compressed_piece *compressed = &compressed_pieces.pieces[i];
+        compressed->data = 0;
+        compressed->status = PIECE_NOT_DONE;
+        const file_piece *piece = &savegame_data.pieces[i];
+        if (!piece->compressed) {
+            continue;
+        }
+        if (savegame_compression_level) {
+            compressed->max_size = deflate_max_compressed_size(piece->buf.size);
+        } else {
+            // the output size must be the same as when compressing the pieces one by one,
+            // because it decides whether a piece is written uncompressed
+            if (!ensure_compress_buffer(piece->buf.size)) {
+                compressed->status = PIECE_SKIPPED;
+                continue;
+            }
+            compressed->max_size = compress_buffer.size;
+        }
+        // largest pieces first, so they do not end up last on a single thread
+        int pos = num_tasks++;
+        while (pos > 0 && savegame_data.pieces[compressed_pieces.order[pos - 1]].buf.size < piece->buf.size) {
+            compressed_pieces.order[pos] = compressed_pieces.order[pos - 1];
+            pos--;
+        }
+        compressed_pieces.order[pos] = i;
+    }
+    if (in_parallel) {
+        system_run_tasks(compress_piece_task, num_tasks, 0);
+    } else {
+        for (int i = 0; i < num_tasks; i++) {
+            compress_piece_task(i, 0);
+        }
+    }
+}
+
+static void write_compressed_piece(FILE *fp, compressed_piece *compressed, const file_piece *piece)
+{
+    switch (compressed->status) {
+        case PIECE_COMPRESSED:
+            write_int32(fp, compressed->size);
+            fwrite(compressed->data, 1, compressed->size, fp);
+            free(compressed->data);
+            compressed->data = 0;
+            break;
+        case PIECE_NOT_COMPRESSIBLE:
+            write_int32(fp, UNCOMPRESSED);
+            fwrite(piece->buf.data, 1, piece->buf.size, fp);
+            break;
+        case PIECE_SKIPPED:
+            break;
+        default:
+            // out of memory on the worker: compress it here
+            write_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+            break;
+    }
+}
+
+static void savegame_write_to_file(FILE *fp, int in_parallel)
+{
+    compress_pieces(in_parallel);
+    if (savegame_compression_level) {
+        write_int32(fp, DEFLATE_SAVE_MAGIC);
+        write_int32(fp, DEFLATE_SAVE_CONTAINER_VERSION);
+    }
     for (int i = 0; i < savegame_data.num_pieces; i++) {
         file_piece *piece = &savegame_data.pieces[i];
         if (piece->compressed) {
-            write_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+            write_compressed_piece(fp, &compressed_pieces.pieces[i], piece);
         } else {
             fwrite(piece->buf.data, 1, piece->buf.size, fp);
         }
+        if (&piece->buf == savegame_data.state.file_version && has_entity_counts(savegame_version)) {
+            buffer *buf = savegame_data.state.entity_counts;
+            fwrite(buf->data, 1, buf->size, fp);
+        }
+    }
+}
+
+static void finish_background_save(void)
+{
+    if (background_save.running) {
+        system_wait_for_background_task();
+        background_save.running = 0;
     }
 }
 
 int game_file_io_read_saved_game(const char *filename, int offset)
 {
+    finish_background_save();
     init_savegame_data();
 
     log_info("Loading saved game", filename, 0);
@@ -643,36 +954,134 @@ int game_file_io_read_saved_game(const char *filename, int offset)
     if (offset) {
         fseek(fp, offset, SEEK_SET);
     }
-    int result = savegame_read_from_file(fp);
+    int result = savegame_read_from_file(fp, offset, 0);
     file_close(fp);
     if (!result) {
         log_error("Unable to load game", 0, 0);
         return 0;
     }
+    if (!reserve_entity_slots(&savegame_data.state)) {
+        log_error("Unable to load game: out of memory", 0, 0);
+        return 0;
+    }
     savegame_load_from_state(&savegame_data.state);
     return 1;
 }
 
-int game_file_io_write_saved_game(const char *filename)
+int game_file_io_read_saved_game_info(const char *filename, saved_game_info *info)
 {
+    finish_background_save();
+    init_savegame_data();
+
+    FILE *fp = file_open(dir_get_file(filename, NOT_LOCALIZED), "rb");
+    if (!fp) {
+        return 0;
+    }
+    int result = savegame_read_from_file(fp, 0, 1);
+    file_close(fp);
+    if (!result) {
+        return 0;
+    }
+    savegame_state *state = &savegame_data.state;
+    info->mission = buffer_read_i32(state->scenario_campaign_mission);
+    buffer_skip(state->game_time, 8);
+    info->month = buffer_read_i32(state->game_time);
+    info->year = buffer_read_i32(state->game_time);
+    city_data_load_basic_info(state->city_data, &info->population, &info->treasury);
+    buffer_read_raw(state->scenario_name, info->scenario_name, SAVED_GAME_INFO_SCENARIO_NAME_LENGTH);
+    info->scenario_name[SAVED_GAME_INFO_SCENARIO_NAME_LENGTH - 1] = 0;
+    return 1;
+}
+
+static int save_state(const char *filename)
+{
+    finish_background_save();
     init_savegame_data();
 
     log_info("Saving game", filename, 0);
-    savegame_version = SAVE_GAME_VERSION;
+    int num_buildings = building_count();
+    int num_figures = figure_count();
+    int num_routes = figure_route_count();
+    int route_path_size = figure_route_path_state_size();
+    if (num_buildings > ORIGINAL_MAX_BUILDINGS || num_figures > ORIGINAL_MAX_FIGURES ||
+        num_routes > ORIGINAL_MAX_ROUTES || route_path_size > ROUTE_PATH_STATE_SIZE) {
+        savegame_version = SAVE_GAME_VERSION_DYNAMIC_COUNTS;
+        if (!resize_entity_pieces(num_buildings, num_figures, num_routes, route_path_size)) {
+            log_error("Unable to save game: out of memory", 0, 0);
+            return 0;
+        }
+    } else {
+        savegame_version = SAVE_GAME_VERSION;
+    }
+    int compression_level = config_get(CONFIG_GP_SAVE_COMPRESSION_LEVEL);
+    savegame_compression_level = compression_level > 0 ? compression_level : 0;
     savegame_save_to_state(&savegame_data.state);
+    return 1;
+}
 
+static int write_state(const char *filename, int in_parallel, int sync)
+{
     FILE *fp = file_open(filename, "wb");
     if (!fp) {
         log_error("Unable to save game", 0, 0);
         return 0;
     }
-    savegame_write_to_file(fp);
+    savegame_write_to_file(fp, in_parallel);
+    if (sync) {
+        file_sync(fp);
+    }
     file_close(fp);
     return 1;
 }
 
+int game_file_io_write_saved_game(const char *filename)
+{
+    if (!save_state(filename)) {
+        return 0;
+    }
+    return write_state(filename, 1, 0);
+}
+
+static void write_state_task(int task_id, void *userdata)
+{
+    // the worker pool belongs to the main thread, so the pieces are compressed here one by one.
+    // The existing file is only replaced once the new one is complete, if the platform can rename files.
+    if (!file_can_replace()) {
+        write_state(background_save.filename, 0, 0);
+    } else if (!write_state(background_save.temp_filename, 0, 1) ||
+        !file_replace(background_save.temp_filename, background_save.filename)) {
+        file_remove(background_save.temp_filename);
+        write_state(background_save.filename, 0, 0);
+    }
+    zip_free_thread_buffers();
+}
+
+int game_file_io_write_saved_game_in_background(const char *filename)
+{
+    if (!save_state(filename)) {
+        return 0;
+    }
+    if (!file_can_write_in_background() || strlen(filename) + 4 >= FILE_NAME_MAX) {
+        return write_state(filename, 1, 0);
+    }
+    strcpy(background_save.filename, filename);
+    strcpy(background_save.temp_filename, filename);
+    strcat(background_save.temp_filename, ".tmp");
+    if (!system_start_background_task(write_state_task, 0)) {
+        return write_state(filename, 1, 0);
+    }
+    background_save.running = 1;
+    return 1;
+}
+
+void game_file_io_finish_background_save(void)
+{
+    finish_background_save();
+}
+
 int game_file_io_delete_saved_game(const char *filename)
 {
+    finish_background_save();
     log_info("Deleting game", filename, 0);
     int result = file_remove(filename);
     if (!result) {
@@ -1,6 +1,19 @@
 #ifndef GAME_FILE_IO_H
 #define GAME_FILE_IO_H
 
+#include <stdint.h>
+
+#define SAVED_GAME_INFO_SCENARIO_NAME_LENGTH 65
+
+typedef struct {
+    int mission;
+    int month;
+    int year;
+    int population;
+    int treasury;
+    uint8_t scenario_name[SAVED_GAME_INFO_SCENARIO_NAME_LENGTH];
+} saved_game_info;
+
 int game_file_io_read_scenario(const char *filename);
 
 int game_file_io_write_scenario(const char *filename);
@@ -9,6 +22,30 @@ int game_file_io_read_saved_game(const char *filename, int offset);
 
 int game_file_io_write_saved_game(const char *filename);
 
+/**
+ * Reads the date, population and scenario of a saved game without loading it.
+ * Only the city data is decompressed, the other compressed pieces are skipped.
+ * @param filename Saved game to read
+ * @param info Info to fill
+ * @return Boolean true on success, false on failure
+ */
+int game_file_io_read_saved_game_info(const char *filename, saved_game_info *info);
+
+/**
+ * Saves the game state in memory and writes it to disk on a background thread.
+ * The file is written under a temporary name and then renamed, so the previous
+ * file stays intact until the new one is complete. Platforms that cannot write
+ * files in the background, or cannot rename them, write the file directly.
+ * @param filename File to save to
+ * @return Boolean true if the state was saved, false on failure
+ */
+int game_file_io_write_saved_game_in_background(const char *filename);
+
+/**
+ * Waits until a saved game written in the background is on disk
+ */
+void game_file_io_finish_background_save(void);
+
 int game_file_io_delete_saved_game(const char *filename);
 
 #endif // GAME_FILE_IO_H
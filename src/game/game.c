@@ -2,6 +2,7 @@
 
 #include "building/model.h"
 #include "city/view.h"
+#include "core/calc.h"
 #include "core/config.h"
 #include "core/hotkey_config.h"
 #include "core/image.h"
@@ -30,6 +31,9 @@
 #include "window/logo.h"
 #include "window/main_menu.h"
 
+// Larger values from the ini file would overflow when converted to bytes
+#define MAX_IMAGE_CACHE_SIZE_MB 1024
+
 static void errlog(const char *msg)
 {
     log_error(msg, 0, 0);
@@ -80,6 +84,8 @@ int game_init(void)
         errlog("unable to init graphics");
         return 0;
     }
+    int cache_size_mb = calc_bound(config_get(CONFIG_SCREEN_IMAGE_CACHE_SIZE), 0, MAX_IMAGE_CACHE_SIZE_MB);
+    image_set_external_cache_size(cache_size_mb * 1024 * 1024);
     if (!image_load_climate(CLIMATE_CENTRAL, 0, 1)) {
         errlog("unable to load main graphics");
         return 0;
@@ -187,6 +193,7 @@ void game_draw(void)
 
 void game_exit(void)
 {
+    game_file_finish_background_save();
     video_shutdown();
     settings_save();
     config_save();
@@ -1,6 +1,7 @@
 #ifndef GAME_SYSTEM_H
 #define GAME_SYSTEM_H
 
+#include "core/time.h"
 #include "graphics/color.h"
 #include "input/keys.h"
 
@@ -152,6 +153,48 @@ void system_set_mouse_position(int *x, int *y);
  */
 color_t *system_create_framebuffer(int width, int height);
 
+/**
+ * Task that can be run on a worker thread
+ * @param task_id Number of the task, from 0 to the number of tasks
+ * @param userdata Data passed to system_run_tasks
+ */
+typedef void (*system_task)(int task_id, void *userdata);
+
+/**
+ * Gets the number of threads that system_run_tasks uses, including the calling thread
+ * @return Number of threads, 1 if tasks are not run in parallel
+ */
+int system_task_thread_count(void);
+
+/**
+ * Runs tasks in parallel on worker threads and waits until all of them are finished
+ * @param task Task to run
+ * @param num_tasks Number of times to run the task
+ * @param userdata Data to pass to the task
+ */
+void system_run_tasks(system_task task, int num_tasks, void *userdata);
+
+/**
+ * Starts a task on a background thread and returns without waiting for it.
+ * Only one background task runs at a time: a previous one is waited for first.
+ * @param task Task to run, with task id 0
+ * @param userdata Data to pass to the task
+ * @return Boolean true if the task was started, false if it could not be started
+ *         and the caller should run it itself
+ */
+int system_start_background_task(system_task task, void *userdata);
+
+/**
+ * Waits until the task started with system_start_background_task is finished
+ */
+void system_wait_for_background_task(void);
+
+/**
+ * Gets the real time, which keeps running when the game time does not
+ * @return Milliseconds since the game was started
+ */
+time_millis system_get_ticks(void);
+
 /**
  * Exit the game
  */
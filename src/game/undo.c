@@ -3,6 +3,7 @@
 #include "building/industry.h"
 #include "building/properties.h"
 #include "building/storage.h"
+#include "building/storage_network.h"
 #include "building/warehouse.h"
 #include "city/finance.h"
 #include "core/image.h"
@@ -100,7 +101,7 @@ int game_undo_start_build(building_type type)
     data.building_cost = 0;
     data.type = type;
     clear_buildings();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_UNDO) {
             data.available = 0;
@@ -209,6 +210,7 @@ void game_undo_perform(void)
             if (data.buildings[i].id) {
                 building *b = building_get(data.buildings[i].id);
                 memcpy(b, &data.buildings[i], sizeof(building));
+                building_update_type_index(b);
                 if (b->type == BUILDING_WAREHOUSE || b->type == BUILDING_GRANARY) {
                     if (!building_storage_restore(b->storage_id)) {
                         building_storage_reset_building_ids();
@@ -217,6 +219,7 @@ void game_undo_perform(void)
                 add_building_to_terrain(b);
             }
         }
+        building_storage_network_update();
         map_terrain_restore();
         map_aqueduct_restore();
         map_sprite_restore();
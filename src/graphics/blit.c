@@ -0,0 +1,409 @@
+#include "blit.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define BLIT_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define BLIT_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BLIT_NEON
+#include <arm_neon.h>
+#endif
+
+#define RB_MASK 0x00ff00ff
+#define G_MASK 0x0000ff00
+
+static struct {
+    const blit_functions *functions;
+} data;
+
+// Scalar versions
+
+static void fill_scalar(color_t *dst, color_t color, int num_pixels)
+{
+    for (int i = 0; i < num_pixels; i++) {
+        dst[i] = color;
+    }
+}
+
+static void copy_masked_scalar(color_t *dst, const color_t *src, color_t color_mask, int num_pixels)
+{
+    for (int i = 0; i < num_pixels; i++) {
+        dst[i] = src[i] & color_mask;
+    }
+}
+
+static void mask_scalar(color_t *dst, color_t color_mask, int num_pixels)
+{
+    for (int i = 0; i < num_pixels; i++) {
+        dst[i] &= color_mask;
+    }
+}
+
+static void blend_alpha_scalar(color_t *dst, color_t color, int num_pixels)
+{
+    color_t alpha = color >> 24;
+    color_t alpha_dst = 256 - alpha;
+    color_t src_rb = (color & 0xff00ff) * alpha;
+    color_t src_g = (color & 0x00ff00) * alpha;
+    for (int i = 0; i < num_pixels; i++) {
+        color_t d = dst[i];
+        dst[i] = (((src_rb + (d & 0xff00ff) * alpha_dst) & 0xff00ff00) |
+                  ((src_g  + (d & 0x00ff00) * alpha_dst) & 0x00ff0000)) >> 8;
+    }
+}
+
+static void copy_opaque_scalar(color_t *dst, const color_t *src, int num_pixels)
+{
+    for (int i = 0; i < num_pixels; i++) {
+        if (src[i] != COLOR_SG2_TRANSPARENT) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+static const blit_functions SCALAR_FUNCTIONS = {
+    fill_scalar, copy_masked_scalar, mask_scalar, blend_alpha_scalar, copy_opaque_scalar
+};
+
+// Blending works on 16-bit lanes: red and blue are blended together, green separately.
+// Each lane holds at most 255 * 256, so the results are the same as the scalar version.
+
+#ifdef BLIT_SSE2
+static void fill_sse2(color_t *dst, color_t color, int num_pixels)
+{
+    __m128i c = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        _mm_storeu_si128((__m128i *) &dst[i], c);
+    }
+    fill_scalar(&dst[i], color, num_pixels - i);
+}
+
+static void copy_masked_sse2(color_t *dst, const color_t *src, color_t color_mask, int num_pixels)
+{
+    __m128i mask = _mm_set1_epi32((int) color_mask);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_and_si128(s, mask));
+    }
+    copy_masked_scalar(&dst[i], &src[i], color_mask, num_pixels - i);
+}
+
+static void mask_sse2(color_t *dst, color_t color_mask, int num_pixels)
+{
+    __m128i mask = _mm_set1_epi32((int) color_mask);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_and_si128(d, mask));
+    }
+    mask_scalar(&dst[i], color_mask, num_pixels - i);
+}
+
+static void blend_alpha_sse2(color_t *dst, color_t color, int num_pixels)
+{
+    color_t alpha = color >> 24;
+    __m128i rb_mask = _mm_set1_epi32(RB_MASK);
+    __m128i g_mask = _mm_set1_epi32(G_MASK);
+    __m128i src_rb = _mm_set1_epi32((int) ((color & RB_MASK) * alpha));
+    __m128i src_g = _mm_set1_epi32((int) (((color >> 8) & 0xff) * alpha));
+    __m128i alpha_dst = _mm_set1_epi16((short) (256 - alpha));
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        __m128i rb = _mm_and_si128(d, rb_mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(d, 8), rb_mask);
+        rb = _mm_add_epi16(_mm_mullo_epi16(rb, alpha_dst), src_rb);
+        g = _mm_add_epi16(_mm_mullo_epi16(g, alpha_dst), src_g);
+        __m128i result = _mm_or_si128(_mm_srli_epi16(rb, 8), _mm_and_si128(g, g_mask));
+        _mm_storeu_si128((__m128i *) &dst[i], result);
+    }
+    blend_alpha_scalar(&dst[i], color, num_pixels - i);
+}
+
+static void copy_opaque_sse2(color_t *dst, const color_t *src, int num_pixels)
+{
+    __m128i transparent = _mm_set1_epi32(COLOR_SG2_TRANSPARENT);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        __m128i is_transparent = _mm_cmpeq_epi32(s, transparent);
+        __m128i result = _mm_or_si128(_mm_and_si128(is_transparent, d), _mm_andnot_si128(is_transparent, s));
+        _mm_storeu_si128((__m128i *) &dst[i], result);
+    }
+    copy_opaque_scalar(&dst[i], &src[i], num_pixels - i);
+}
+
+static const blit_functions SSE2_FUNCTIONS = {
+    fill_sse2, copy_masked_sse2, mask_sse2, blend_alpha_sse2, copy_opaque_sse2
+};
+#endif
+
+#ifdef BLIT_AVX2
+// The tails are handled here as well: calling the non-AVX versions would cause
+// costly AVX to SSE transitions
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static void fill_avx2(color_t *dst, color_t color, int num_pixels)
+{
+    __m256i c = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 8 <= num_pixels; i += 8) {
+        _mm256_storeu_si256((__m256i *) &dst[i], c);
+    }
+    if (i + 4 <= num_pixels) {
+        _mm_storeu_si128((__m128i *) &dst[i], _mm256_castsi256_si128(c));
+        i += 4;
+    }
+    for (; i < num_pixels; i++) {
+        dst[i] = color;
+    }
+}
+
+AVX2 static void copy_masked_avx2(color_t *dst, const color_t *src, color_t color_mask, int num_pixels)
+{
+    __m256i mask = _mm256_set1_epi32((int) color_mask);
+    int i = 0;
+    for (; i + 8 <= num_pixels; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) &src[i]);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_and_si256(s, mask));
+    }
+    if (i + 4 <= num_pixels) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_and_si128(s, _mm256_castsi256_si128(mask)));
+        i += 4;
+    }
+    for (; i < num_pixels; i++) {
+        dst[i] = src[i] & color_mask;
+    }
+}
+
+AVX2 static void mask_avx2(color_t *dst, color_t color_mask, int num_pixels)
+{
+    __m256i mask = _mm256_set1_epi32((int) color_mask);
+    int i = 0;
+    for (; i + 8 <= num_pixels; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *) &dst[i]);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_and_si256(d, mask));
+    }
+    if (i + 4 <= num_pixels) {
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_and_si128(d, _mm256_castsi256_si128(mask)));
+        i += 4;
+    }
+    for (; i < num_pixels; i++) {
+        dst[i] &= color_mask;
+    }
+}
+
+AVX2 static __m256i blend_alpha_8_avx2(__m256i d, __m256i src_rb, __m256i src_g, __m256i alpha_dst)
+{
+    __m256i rb_mask = _mm256_set1_epi32(RB_MASK);
+    __m256i rb = _mm256_and_si256(d, rb_mask);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(d, 8), rb_mask);
+    rb = _mm256_add_epi16(_mm256_mullo_epi16(rb, alpha_dst), src_rb);
+    g = _mm256_add_epi16(_mm256_mullo_epi16(g, alpha_dst), src_g);
+    return _mm256_or_si256(_mm256_srli_epi16(rb, 8), _mm256_and_si256(g, _mm256_set1_epi32(G_MASK)));
+}
+
+AVX2 static void blend_alpha_avx2(color_t *dst, color_t color, int num_pixels)
+{
+    color_t alpha = color >> 24;
+    __m256i src_rb = _mm256_set1_epi32((int) ((color & RB_MASK) * alpha));
+    __m256i src_g = _mm256_set1_epi32((int) (((color >> 8) & 0xff) * alpha));
+    __m256i alpha_dst = _mm256_set1_epi16((short) (256 - alpha));
+    int i = 0;
+    for (; i + 8 <= num_pixels; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *) &dst[i]);
+        _mm256_storeu_si256((__m256i *) &dst[i], blend_alpha_8_avx2(d, src_rb, src_g, alpha_dst));
+    }
+    if (i + 4 <= num_pixels) {
+        __m256i d = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) &dst[i]));
+        __m256i result = blend_alpha_8_avx2(d, src_rb, src_g, alpha_dst);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm256_castsi256_si128(result));
+        i += 4;
+    }
+    color_t alpha_dst_scalar = 256 - alpha;
+    color_t src_rb_scalar = (color & 0xff00ff) * alpha;
+    color_t src_g_scalar = (color & 0x00ff00) * alpha;
+    for (; i < num_pixels; i++) {
+        color_t c = dst[i];
+        dst[i] = (((src_rb_scalar + (c & 0xff00ff) * alpha_dst_scalar) & 0xff00ff00) |
+                  ((src_g_scalar  + (c & 0x00ff00) * alpha_dst_scalar) & 0x00ff0000)) >> 8;
+    }
+}
+
+AVX2 static void copy_opaque_avx2(color_t *dst, const color_t *src, int num_pixels)
+{
+    __m256i transparent = _mm256_set1_epi32(COLOR_SG2_TRANSPARENT);
+    int i = 0;
+    for (; i + 8 <= num_pixels; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) &src[i]);
+        __m256i d = _mm256_loadu_si256((const __m256i *) &dst[i]);
+        __m256i is_transparent = _mm256_cmpeq_epi32(s, transparent);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_blendv_epi8(s, d, is_transparent));
+    }
+    if (i + 4 <= num_pixels) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        __m128i is_transparent = _mm_cmpeq_epi32(s, _mm256_castsi256_si128(transparent));
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_blendv_epi8(s, d, is_transparent));
+        i += 4;
+    }
+    for (; i < num_pixels; i++) {
+        if (src[i] != COLOR_SG2_TRANSPARENT) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+static const blit_functions AVX2_FUNCTIONS = {
+    fill_avx2, copy_masked_avx2, mask_avx2, blend_alpha_avx2, copy_opaque_avx2
+};
+#endif
+
+#ifdef BLIT_NEON
+static void fill_neon(color_t *dst, color_t color, int num_pixels)
+{
+    uint32x4_t c = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        vst1q_u32(&dst[i], c);
+    }
+    fill_scalar(&dst[i], color, num_pixels - i);
+}
+
+static void copy_masked_neon(color_t *dst, const color_t *src, color_t color_mask, int num_pixels)
+{
+    uint32x4_t mask = vdupq_n_u32(color_mask);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        vst1q_u32(&dst[i], vandq_u32(vld1q_u32(&src[i]), mask));
+    }
+    copy_masked_scalar(&dst[i], &src[i], color_mask, num_pixels - i);
+}
+
+static void mask_neon(color_t *dst, color_t color_mask, int num_pixels)
+{
+    uint32x4_t mask = vdupq_n_u32(color_mask);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        vst1q_u32(&dst[i], vandq_u32(vld1q_u32(&dst[i]), mask));
+    }
+    mask_scalar(&dst[i], color_mask, num_pixels - i);
+}
+
+static void blend_alpha_neon(color_t *dst, color_t color, int num_pixels)
+{
+    color_t alpha = color >> 24;
+    uint32x4_t rb_mask = vdupq_n_u32(RB_MASK);
+    uint32x4_t g_mask = vdupq_n_u32(G_MASK);
+    uint16x8_t src_rb = vreinterpretq_u16_u32(vdupq_n_u32((color & RB_MASK) * alpha));
+    uint16x8_t src_g = vreinterpretq_u16_u32(vdupq_n_u32(((color >> 8) & 0xff) * alpha));
+    uint16x8_t alpha_dst = vdupq_n_u16((uint16_t) (256 - alpha));
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        uint32x4_t d = vld1q_u32(&dst[i]);
+        uint16x8_t rb = vreinterpretq_u16_u32(vandq_u32(d, rb_mask));
+        uint16x8_t g = vreinterpretq_u16_u32(vandq_u32(vshrq_n_u32(d, 8), rb_mask));
+        rb = vmlaq_u16(src_rb, rb, alpha_dst);
+        g = vmlaq_u16(src_g, g, alpha_dst);
+        uint32x4_t result = vorrq_u32(vreinterpretq_u32_u16(vshrq_n_u16(rb, 8)),
+            vandq_u32(vreinterpretq_u32_u16(g), g_mask));
+        vst1q_u32(&dst[i], result);
+    }
+    blend_alpha_scalar(&dst[i], color, num_pixels - i);
+}
+
+static void copy_opaque_neon(color_t *dst, const color_t *src, int num_pixels)
+{
+    uint32x4_t transparent = vdupq_n_u32(COLOR_SG2_TRANSPARENT);
+    int i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        uint32x4_t s = vld1q_u32(&src[i]);
+        uint32x4_t is_transparent = vceqq_u32(s, transparent);
+        vst1q_u32(&dst[i], vbslq_u32(is_transparent, vld1q_u32(&dst[i]), s));
+    }
+    copy_opaque_scalar(&dst[i], &src[i], num_pixels - i);
+}
+
+static const blit_functions NEON_FUNCTIONS = {
+    fill_neon, copy_masked_neon, mask_neon, blend_alpha_neon, copy_opaque_neon
+};
+#endif
+
+static const blit_functions *get_functions(blit_implementation implementation)
+{
+    switch (implementation) {
+        case BLIT_IMPLEMENTATION_SCALAR:
+            return &SCALAR_FUNCTIONS;
+#ifdef BLIT_SSE2
+        case BLIT_IMPLEMENTATION_SSE2:
+            return &SSE2_FUNCTIONS;
+#endif
+#ifdef BLIT_AVX2
+        case BLIT_IMPLEMENTATION_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &AVX2_FUNCTIONS : 0;
+#endif
+#ifdef BLIT_NEON
+        case BLIT_IMPLEMENTATION_NEON:
+            return &NEON_FUNCTIONS;
+#endif
+        default:
+            return 0;
+    }
+}
+
+void blit_init(void)
+{
+    for (int i = BLIT_IMPLEMENTATION_MAX - 1; i >= 0; i--) {
+        if (blit_set_implementation((blit_implementation) i)) {
+            return;
+        }
+    }
+}
+
+const blit_functions *blit_get_functions(void)
+{
+    if (!data.functions) {
+        blit_init();
+    }
+    return data.functions;
+}
+
+int blit_is_supported(blit_implementation implementation)
+{
+    return get_functions(implementation) != 0;
+}
+
+int blit_set_implementation(blit_implementation implementation)
+{
+    const blit_functions *functions = get_functions(implementation);
+    if (!functions) {
+        return 0;
+    }
+    data.functions = functions;
+    return 1;
+}
+
+const char *blit_implementation_name(blit_implementation implementation)
+{
+    switch (implementation) {
+        case BLIT_IMPLEMENTATION_SCALAR:
+            return "scalar";
+        case BLIT_IMPLEMENTATION_SSE2:
+            return "SSE2";
+        case BLIT_IMPLEMENTATION_AVX2:
+            return "AVX2";
+        case BLIT_IMPLEMENTATION_NEON:
+            return "NEON";
+        default:
+            return "unknown";
+    }
+}
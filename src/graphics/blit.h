@@ -0,0 +1,68 @@
+#ifndef GRAPHICS_BLIT_H
+#define GRAPHICS_BLIT_H
+
+#include "graphics/color.h"
+
+/**
+ * @file
+ * Pixel run kernels used by the image drawing functions.
+ *
+ * Every kernel has a plain C version and, depending on the platform,
+ * SSE2, AVX2 or NEON versions. The fastest version the CPU supports is
+ * selected at runtime. All versions produce exactly the same pixels.
+ */
+
+typedef enum {
+    BLIT_IMPLEMENTATION_SCALAR,
+    BLIT_IMPLEMENTATION_SSE2,
+    BLIT_IMPLEMENTATION_AVX2,
+    BLIT_IMPLEMENTATION_NEON,
+    BLIT_IMPLEMENTATION_MAX
+} blit_implementation;
+
+typedef struct {
+    /** Sets every pixel to the color */
+    void (*fill)(color_t *dst, color_t color, int num_pixels);
+    /** Copies pixels from src, masked with the color mask */
+    void (*copy_masked)(color_t *dst, const color_t *src, color_t color_mask, int num_pixels);
+    /** Masks the pixels in dst with the color mask */
+    void (*mask)(color_t *dst, color_t color_mask, int num_pixels);
+    /** Blends the color over the pixels, using the alpha of the color, which must be between 1 and 254 */
+    void (*blend_alpha)(color_t *dst, color_t color, int num_pixels);
+    /** Copies pixels from src that are not COLOR_SG2_TRANSPARENT */
+    void (*copy_opaque)(color_t *dst, const color_t *src, int num_pixels);
+} blit_functions;
+
+/**
+ * Selects the fastest implementation supported by the CPU
+ */
+void blit_init(void);
+
+/**
+ * Gets the kernels of the current implementation
+ * @return Kernels
+ */
+const blit_functions *blit_get_functions(void);
+
+/**
+ * Checks whether an implementation can be used on this CPU
+ * @param implementation Implementation to check
+ * @return Boolean true if supported
+ */
+int blit_is_supported(blit_implementation implementation);
+
+/**
+ * Forces an implementation, for testing and benchmarking
+ * @param implementation Implementation to use
+ * @return Boolean true if the implementation is supported and now used
+ */
+int blit_set_implementation(blit_implementation implementation);
+
+/**
+ * Gets the name of an implementation
+ * @param implementation Implementation
+ * @return Name
+ */
+const char *blit_implementation_name(blit_implementation implementation);
+
+#endif // GRAPHICS_BLIT_H
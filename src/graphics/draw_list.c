@@ -0,0 +1,284 @@
+#include "draw_list.h"
+
+#include "core/image.h"
+#include "game/system.h"
+#include "graphics/graphics.h"
+#include "graphics/image.h"
+#include "graphics/screen.h"
+
+#include <stdlib.h>
+
+#define COMMANDS_CHUNK 4096
+#define MIN_COMMANDS_FOR_BANDS 64
+#define BANDS_PER_THREAD 2
+
+typedef enum {
+    STATE_IDLE,
+    STATE_RECORDING,
+    STATE_PAUSED
+} list_state;
+
+typedef struct {
+    draw_command_type type;
+    int id;
+    int x;
+    int y;
+    int width;
+    int height;
+    color_t color;
+    const color_t *buffer;
+} draw_command;
+
+static struct {
+    list_state state;
+    draw_command *commands;
+    int num_commands;
+    int capacity;
+    int sequential_only;
+    int clip_changed;
+    graphics_state start_state;
+    int first_row;
+    int last_row;
+    int band_height;
+} data;
+
+void draw_list_begin(void)
+{
+    if (data.state != STATE_IDLE) {
+        return;
+    }
+    data.state = STATE_RECORDING;
+    data.num_commands = 0;
+    data.sequential_only = 0;
+    data.clip_changed = 0;
+    graphics_save_state(&data.start_state);
+}
+
+int draw_list_is_recording(void)
+{
+    return data.state == STATE_RECORDING;
+}
+
+void draw_list_pause(void)
+{
+    if (data.state == STATE_RECORDING) {
+        data.state = STATE_PAUSED;
+    }
+}
+
+void draw_list_resume(void)
+{
+    if (data.state == STATE_PAUSED) {
+        data.state = STATE_RECORDING;
+    }
+}
+
+static void execute(const draw_command *c)
+{
+    switch (c->type) {
+        case DRAW_COMMAND_IMAGE:
+            image_draw(c->id, c->x, c->y);
+            break;
+        case DRAW_COMMAND_IMAGE_ENEMY:
+            image_draw_enemy(c->id, c->x, c->y);
+            break;
+        case DRAW_COMMAND_IMAGE_MASKED:
+            image_draw_masked(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_IMAGE_BLEND:
+            image_draw_blend(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_IMAGE_BLEND_ALPHA:
+            image_draw_blend_alpha(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_IMAGE_SCALED_DOWN:
+            image_draw_scaled_down(c->id, c->x, c->y, (unsigned int) c->width);
+            break;
+        case DRAW_COMMAND_LETTER:
+            image_draw_letter((font_t) c->width, c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_ISOMETRIC_FOOTPRINT:
+            image_draw_isometric_footprint(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_ISOMETRIC_FOOTPRINT_FROM_DRAW_TILE:
+            image_draw_isometric_footprint_from_draw_tile(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_ISOMETRIC_TOP:
+            image_draw_isometric_top(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_ISOMETRIC_TOP_FROM_DRAW_TILE:
+            image_draw_isometric_top_from_draw_tile(c->id, c->x, c->y, c->color);
+            break;
+        case DRAW_COMMAND_IN_DIALOG:
+            graphics_in_dialog();
+            break;
+        case DRAW_COMMAND_RESET_DIALOG:
+            graphics_reset_dialog();
+            break;
+        case DRAW_COMMAND_SET_CLIP_RECTANGLE:
+            graphics_set_clip_rectangle(c->x, c->y, c->width, c->height);
+            break;
+        case DRAW_COMMAND_RESET_CLIP_RECTANGLE:
+            graphics_reset_clip_rectangle();
+            break;
+        case DRAW_COMMAND_FROM_BUFFER:
+            graphics_draw_from_buffer(c->x, c->y, c->width, c->height, c->buffer);
+            break;
+        case DRAW_COMMAND_VERTICAL_LINE:
+            graphics_draw_vertical_line(c->x, c->y, c->height, c->color);
+            break;
+        case DRAW_COMMAND_HORIZONTAL_LINE:
+            graphics_draw_horizontal_line(c->x, c->width, c->y, c->color);
+            break;
+        case DRAW_COMMAND_FILL_RECT:
+            graphics_fill_rect(c->x, c->y, c->width, c->height, c->color);
+            break;
+        case DRAW_COMMAND_SHADE_RECT:
+            graphics_shade_rect(c->x, c->y, c->width, c->height, c->id);
+            break;
+    }
+}
+
+static void draw_band(int band, void *userdata)
+{
+    int y_start = data.first_row + band * data.band_height;
+    int y_end = y_start + data.band_height;
+    if (y_end > data.last_row) {
+        y_end = data.last_row;
+    }
+    graphics_restore_state(&data.start_state);
+    graphics_set_band(y_start, y_end);
+    for (int i = 0; i < data.num_commands; i++) {
+        execute(&data.commands[i]);
+    }
+    graphics_clear_band();
+}
+
+static void draw_commands(void)
+{
+    if (!data.num_commands) {
+        return;
+    }
+    list_state state = data.state;
+    data.state = STATE_IDLE;
+    graphics_state end_state;
+    graphics_save_state(&end_state);
+
+    int first_column, last_column;
+    if (data.clip_changed) {
+        // the clip rectangle may grow, so the bands cover the whole screen
+        first_column = 0;
+        last_column = screen_width();
+        data.first_row = 0;
+        data.last_row = screen_height();
+    } else {
+        first_column = data.start_state.translation_x + data.start_state.clip_x_start;
+        last_column = data.start_state.translation_x + data.start_state.clip_x_end;
+        data.first_row = data.start_state.translation_y + data.start_state.clip_y_start;
+        data.last_row = data.start_state.translation_y + data.start_state.clip_y_end;
+    }
+    int threads = system_task_thread_count();
+    int num_bands = 1;
+    if (threads > 1 && !data.sequential_only && data.num_commands >= MIN_COMMANDS_FOR_BANDS) {
+        num_bands = threads * BANDS_PER_THREAD;
+    }
+    int rows = data.last_row - data.first_row;
+    if (rows > 0) {
+        // bands do not track what they change, so mark everything they can reach
+        graphics_mark_dirty(first_column, data.first_row, last_column - first_column, rows);
+        data.band_height = (rows + num_bands - 1) / num_bands;
+        num_bands = (rows + data.band_height - 1) / data.band_height;
+        if (num_bands > 1) {
+            system_run_tasks(draw_band, num_bands, 0);
+        } else {
+            draw_band(0, 0);
+        }
+    }
+    graphics_restore_state(&end_state);
+    // the next commands continue from the current state
+    data.start_state = end_state;
+    data.num_commands = 0;
+    data.sequential_only = 0;
+    data.clip_changed = 0;
+    data.state = state;
+}
+
+void draw_list_end(void)
+{
+    if (data.state == STATE_IDLE) {
+        return;
+    }
+    draw_commands();
+    data.state = STATE_IDLE;
+}
+
+static int is_external_image(draw_command_type type, int id)
+{
+    switch (type) {
+        case DRAW_COMMAND_IMAGE:
+        case DRAW_COMMAND_IMAGE_MASKED:
+        case DRAW_COMMAND_IMAGE_BLEND:
+        case DRAW_COMMAND_IMAGE_BLEND_ALPHA:
+        case DRAW_COMMAND_IMAGE_SCALED_DOWN:
+            return image_get(id)->draw.is_external;
+        default:
+            return 0;
+    }
+}
+
+static draw_command *new_command(void)
+{
+    if (data.num_commands >= data.capacity) {
+        int capacity = data.capacity + COMMANDS_CHUNK;
+        draw_command *commands = (draw_command *) realloc(data.commands, capacity * sizeof(draw_command));
+        if (!commands) {
+            // out of memory: draw what we have so the order stays intact
+            draw_commands();
+            if (!data.capacity) {
+                return 0;
+            }
+        } else {
+            data.commands = commands;
+            data.capacity = capacity;
+        }
+    }
+    return &data.commands[data.num_commands++];
+}
+
+static void add_command(const draw_command *command)
+{
+    draw_command *c = new_command();
+    if (!c) {
+        data.state = STATE_PAUSED;
+        execute(command);
+        data.state = STATE_RECORDING;
+        return;
+    }
+    *c = *command;
+    switch (command->type) {
+        case DRAW_COMMAND_IN_DIALOG:
+        case DRAW_COMMAND_RESET_DIALOG:
+        case DRAW_COMMAND_SET_CLIP_RECTANGLE:
+        case DRAW_COMMAND_RESET_CLIP_RECTANGLE:
+            data.clip_changed = 1;
+            break;
+        default:
+            if (is_external_image(command->type, command->id)) {
+                // external images are loaded into a shared buffer when drawn
+                data.sequential_only = 1;
+            }
+            break;
+    }
+}
+
+void draw_list_add(draw_command_type type, int id, int x, int y, int width, int height, color_t color)
+{
+    draw_command command = { type, id, x, y, width, height, color, 0 };
+    add_command(&command);
+}
+
+void draw_list_add_buffer(int x, int y, int width, int height, const color_t *buffer)
+{
+    draw_command command = { DRAW_COMMAND_FROM_BUFFER, 0, x, y, width, height, 0, buffer };
+    add_command(&command);
+}
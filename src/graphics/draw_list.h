@@ -0,0 +1,87 @@
+#ifndef GRAPHICS_DRAW_LIST_H
+#define GRAPHICS_DRAW_LIST_H
+
+#include "graphics/color.h"
+
+/**
+ * @file
+ * Draw list: records drawing commands so they can be drawn later in
+ * horizontal bands of the screen, in parallel on multiple threads.
+ *
+ * Each band draws all commands in the recorded order, clipped to its rows,
+ * so the result is exactly the same as drawing them directly.
+ */
+
+typedef enum {
+    DRAW_COMMAND_IMAGE,
+    DRAW_COMMAND_IMAGE_ENEMY,
+    DRAW_COMMAND_IMAGE_MASKED,
+    DRAW_COMMAND_IMAGE_BLEND,
+    DRAW_COMMAND_IMAGE_BLEND_ALPHA,
+    DRAW_COMMAND_IMAGE_SCALED_DOWN,
+    DRAW_COMMAND_LETTER,
+    DRAW_COMMAND_ISOMETRIC_FOOTPRINT,
+    DRAW_COMMAND_ISOMETRIC_FOOTPRINT_FROM_DRAW_TILE,
+    DRAW_COMMAND_ISOMETRIC_TOP,
+    DRAW_COMMAND_ISOMETRIC_TOP_FROM_DRAW_TILE,
+    DRAW_COMMAND_IN_DIALOG,
+    DRAW_COMMAND_RESET_DIALOG,
+    DRAW_COMMAND_SET_CLIP_RECTANGLE,
+    DRAW_COMMAND_RESET_CLIP_RECTANGLE,
+    DRAW_COMMAND_FROM_BUFFER,
+    DRAW_COMMAND_VERTICAL_LINE,
+    DRAW_COMMAND_HORIZONTAL_LINE,
+    DRAW_COMMAND_FILL_RECT,
+    DRAW_COMMAND_SHADE_RECT
+} draw_command_type;
+
+/**
+ * Starts recording drawing commands instead of drawing them
+ */
+void draw_list_begin(void);
+
+/**
+ * Stops recording and draws all recorded commands, in parallel bands when possible
+ */
+void draw_list_end(void);
+
+/**
+ * Checks whether drawing commands are being recorded
+ * @return Boolean true if drawing functions should add a command instead of drawing
+ */
+int draw_list_is_recording(void);
+
+/**
+ * Temporarily draws directly, for example when drawing to a custom canvas
+ */
+void draw_list_pause(void);
+
+/**
+ * Continues recording after draw_list_pause
+ */
+void draw_list_resume(void);
+
+/**
+ * Adds a drawing command. The meaning of the parameters depends on the command,
+ * they are the same as the parameters of the corresponding drawing function.
+ * @param type Command type
+ * @param id Image, letter or darkness
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param width Width, font, scale factor or x2 of a line
+ * @param height Height or y2 of a line
+ * @param color Color or color mask
+ */
+void draw_list_add(draw_command_type type, int id, int x, int y, int width, int height, color_t color);
+
+/**
+ * Adds a command to draw from a buffer. The buffer must stay valid until draw_list_end.
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param width Width of the buffer
+ * @param height Height of the buffer
+ * @param buffer Buffer to draw
+ */
+void draw_list_add_buffer(int x, int y, int width, int height, const color_t *buffer);
+
+#endif // GRAPHICS_DRAW_LIST_H
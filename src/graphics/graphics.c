@@ -1,30 +1,64 @@
 #include "graphics.h"
 
+#include "core/thread.h"
 #include "game/system.h"
+#include "graphics/blit.h"
+#include "graphics/draw_list.h"
 #include "graphics/screen.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define MAX_DIRTY_RECTS 16
+// Merging rectangles that waste fewer pixels than this saves upload calls
+#define DIRTY_MERGE_SLACK 4096
+
 static struct {
     color_t *pixels;
     int width;
     int height;
 } canvas;
 
-static struct {
+// Clipping and translation are per thread so bands of the screen can be drawn in parallel
+static THREAD_LOCAL struct {
     int x_start;
     int x_end;
     int y_start;
     int y_end;
 } clip_rectangle = {0, 800, 0, 600};
 
-static struct {
+static THREAD_LOCAL struct {
     int x;
     int y;
 } translation;
 
-static clip_info clip;
+static THREAD_LOCAL clip_info clip;
+
+static THREAD_LOCAL struct {
+    int active;
+    int y_start;
+    int y_end;
+} band;
+
+static struct {
+    int active;
+    color_t *pixels;
+    int width;
+    int height;
+    int translation_x;
+    int translation_y;
+    int x_start;
+    int x_end;
+    int y_start;
+    int y_end;
+} original_canvas;
+
+// Only changed on the main thread: drawing in bands does not mark anything
+static struct {
+    graphics_rect rects[MAX_DIRTY_RECTS];
+    int num_rects;
+} dirty;
 
 void graphics_init_canvas(int width, int height)
 {
@@ -33,7 +67,10 @@ void graphics_init_canvas(int width, int height)
     canvas.width = width;
     canvas.height = height;
 
+    blit_init();
     graphics_set_clip_rectangle(0, 0, width, height);
+    graphics_clear_dirty_rects();
+    graphics_mark_dirty(0, 0, width, height);
 }
 
 const void *graphics_canvas(void)
@@ -41,6 +78,167 @@ const void *graphics_canvas(void)
     return canvas.pixels;
 }
 
+void graphics_set_custom_canvas(color_t *pixels, int x, int y, int width, int height)
+{
+    if (!original_canvas.active) {
+        // drawing to the custom canvas happens right away
+        draw_list_pause();
+        original_canvas.active = 1;
+        original_canvas.pixels = canvas.pixels;
+        original_canvas.width = canvas.width;
+        original_canvas.height = canvas.height;
+        original_canvas.translation_x = translation.x;
+        original_canvas.translation_y = translation.y;
+        original_canvas.x_start = clip_rectangle.x_start;
+        original_canvas.x_end = clip_rectangle.x_end;
+        original_canvas.y_start = clip_rectangle.y_start;
+        original_canvas.y_end = clip_rectangle.y_end;
+    }
+    canvas.pixels = pixels;
+    canvas.width = width;
+    canvas.height = height;
+    translation.x = -x;
+    translation.y = -y;
+    clip_rectangle.x_start = x;
+    clip_rectangle.x_end = x + width;
+    clip_rectangle.y_start = y;
+    clip_rectangle.y_end = y + height;
+}
+
+void graphics_restore_canvas(void)
+{
+    if (!original_canvas.active) {
+        return;
+    }
+    original_canvas.active = 0;
+    canvas.pixels = original_canvas.pixels;
+    canvas.width = original_canvas.width;
+    canvas.height = original_canvas.height;
+    translation.x = original_canvas.translation_x;
+    translation.y = original_canvas.translation_y;
+    clip_rectangle.x_start = original_canvas.x_start;
+    clip_rectangle.x_end = original_canvas.x_end;
+    clip_rectangle.y_start = original_canvas.y_start;
+    clip_rectangle.y_end = original_canvas.y_end;
+    draw_list_resume();
+}
+
+void graphics_save_state(graphics_state *state)
+{
+    state->translation_x = translation.x;
+    state->translation_y = translation.y;
+    state->clip_x_start = clip_rectangle.x_start;
+    state->clip_x_end = clip_rectangle.x_end;
+    state->clip_y_start = clip_rectangle.y_start;
+    state->clip_y_end = clip_rectangle.y_end;
+}
+
+void graphics_restore_state(const graphics_state *state)
+{
+    translation.x = state->translation_x;
+    translation.y = state->translation_y;
+    clip_rectangle.x_start = state->clip_x_start;
+    clip_rectangle.x_end = state->clip_x_end;
+    clip_rectangle.y_start = state->clip_y_start;
+    clip_rectangle.y_end = state->clip_y_end;
+}
+
+static void apply_band(void)
+{
+    if (!band.active) {
+        return;
+    }
+    if (translation.y + clip_rectangle.y_start < band.y_start) {
+        clip_rectangle.y_start = band.y_start - translation.y;
+    }
+    if (translation.y + clip_rectangle.y_end > band.y_end) {
+        clip_rectangle.y_end = band.y_end - translation.y;
+    }
+}
+
+void graphics_set_band(int y_start, int y_end)
+{
+    band.active = 1;
+    band.y_start = y_start;
+    band.y_end = y_end;
+    apply_band();
+}
+
+void graphics_clear_band(void)
+{
+    band.active = 0;
+}
+
+static int wasted_pixels_on_merge(const graphics_rect *r, int x, int y, int x_end, int y_end)
+{
+    int union_width = (x_end > r->x + r->width ? x_end : r->x + r->width) - (x < r->x ? x : r->x);
+    int union_height = (y_end > r->y + r->height ? y_end : r->y + r->height) - (y < r->y ? y : r->y);
+    return union_width * union_height - r->width * r->height - (x_end - x) * (y_end - y);
+}
+
+static void merge_rect(graphics_rect *r, int x, int y, int x_end, int y_end)
+{
+    int r_x_end = r->x + r->width;
+    int r_y_end = r->y + r->height;
+    r->x = x < r->x ? x : r->x;
+    r->y = y < r->y ? y : r->y;
+    r->width = (x_end > r_x_end ? x_end : r_x_end) - r->x;
+    r->height = (y_end > r_y_end ? y_end : r_y_end) - r->y;
+}
+
+void graphics_mark_dirty(int x, int y, int width, int height)
+{
+    int x_end = x + width;
+    int y_end = y + height;
+    x = x < 0 ? 0 : x;
+    y = y < 0 ? 0 : y;
+    x_end = x_end > canvas.width ? canvas.width : x_end;
+    y_end = y_end > canvas.height ? canvas.height : y_end;
+    if (x >= x_end || y >= y_end) {
+        return;
+    }
+    int best_index = -1;
+    int best_waste = INT_MAX;
+    for (int i = dirty.num_rects - 1; i >= 0; i--) {
+        int waste = wasted_pixels_on_merge(&dirty.rects[i], x, y, x_end, y_end);
+        if (waste <= DIRTY_MERGE_SLACK) {
+            merge_rect(&dirty.rects[i], x, y, x_end, y_end);
+            return;
+        }
+        if (waste < best_waste) {
+            best_waste = waste;
+            best_index = i;
+        }
+    }
+    if (dirty.num_rects < MAX_DIRTY_RECTS) {
+        graphics_rect *r = &dirty.rects[dirty.num_rects++];
+        r->x = x;
+        r->y = y;
+        r->width = x_end - x;
+        r->height = y_end - y;
+    } else {
+        merge_rect(&dirty.rects[best_index], x, y, x_end, y_end);
+    }
+}
+
+const graphics_rect *graphics_get_dirty_rects(int *num_rects)
+{
+    *num_rects = dirty.num_rects;
+    return dirty.rects;
+}
+
+void graphics_clear_dirty_rects(void)
+{
+    dirty.num_rects = 0;
+}
+
+static void mark_dirty_local(int x, int y, int width, int height)
+{
+    if (!band.active && !original_canvas.active) {
+        graphics_mark_dirty(translation.x + x, translation.y + y, width, height);
+    }
+}
+
 static void translate_clip(int dx, int dy)
 {
     clip_rectangle.x_start -= dx;
@@ -60,16 +258,25 @@ static void set_translation(int x, int y)
 
 void graphics_in_dialog(void)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IN_DIALOG, 0, 0, 0, 0, 0, 0);
+    }
     set_translation(screen_dialog_offset_x(), screen_dialog_offset_y());
 }
 
 void graphics_reset_dialog(void)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_RESET_DIALOG, 0, 0, 0, 0, 0, 0);
+    }
     set_translation(0, 0);
 }
 
 void graphics_set_clip_rectangle(int x, int y, int width, int height)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_SET_CLIP_RECTANGLE, 0, x, y, width, height, 0);
+    }
     clip_rectangle.x_start = x;
     clip_rectangle.x_end = x + width;
     clip_rectangle.y_start = y;
@@ -87,15 +294,20 @@ void graphics_set_clip_rectangle(int x, int y, int width, int height)
     if (translation.y + clip_rectangle.y_end > canvas.height) {
         clip_rectangle.y_end = canvas.height - translation.y;
     }
+    apply_band();
 }
 
 void graphics_reset_clip_rectangle(void)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_RESET_CLIP_RECTANGLE, 0, 0, 0, 0, 0, 0);
+    }
     clip_rectangle.x_start = 0;
     clip_rectangle.x_end = canvas.width;
     clip_rectangle.y_start = 0;
     clip_rectangle.y_end = canvas.height;
     translate_clip(translation.x, translation.y);
+    apply_band();
 }
 
 static void set_clip_x(int x_offset, int width)
@@ -153,7 +365,7 @@ static void set_clip_y(int y_offset, int height)
     clip.visible_pixels_y = height - clip.clipped_pixels_top - clip.clipped_pixels_bottom;
 }
 
-const clip_info *graphics_get_clip_info(int x, int y, int width, int height)
+static const clip_info *calculate_clip(int x, int y, int width, int height)
 {
     set_clip_x(x, width);
     set_clip_y(y, height);
@@ -165,9 +377,19 @@ const clip_info *graphics_get_clip_info(int x, int y, int width, int height)
     return &clip;
 }
 
+const clip_info *graphics_get_clip_info(int x, int y, int width, int height)
+{
+    calculate_clip(x, y, width, height);
+    if (clip.is_visible) {
+        mark_dirty_local(x + clip.clipped_pixels_left, y + clip.clipped_pixels_top,
+            clip.visible_pixels_x, clip.visible_pixels_y);
+    }
+    return &clip;
+}
+
 void graphics_save_to_buffer(int x, int y, int width, int height, color_t *buffer)
 {
-    const clip_info *current_clip = graphics_get_clip_info(x, y, width, height);
+    const clip_info *current_clip = calculate_clip(x, y, width, height);
     if (!current_clip->is_visible) {
         return;
     }
@@ -182,6 +404,10 @@ void graphics_save_to_buffer(int x, int y, int width, int height, color_t *buffe
 
 void graphics_draw_from_buffer(int x, int y, int width, int height, const color_t *buffer)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add_buffer(x, y, width, height, buffer);
+        return;
+    }
     const clip_info *current_clip = graphics_get_clip_info(x, y, width, height);
     if (!current_clip->is_visible) {
         return;
@@ -203,10 +429,17 @@ color_t *graphics_get_pixel(int x, int y)
 void graphics_clear_screen(void)
 {
     memset(canvas.pixels, 0, sizeof(color_t) * canvas.width * canvas.height);
+    if (!original_canvas.active) {
+        graphics_mark_dirty(0, 0, canvas.width, canvas.height);
+    }
 }
 
 void graphics_draw_vertical_line(int x, int y1, int y2, color_t color)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_VERTICAL_LINE, 0, x, y1, 0, y2, color);
+        return;
+    }
     if (x < clip_rectangle.x_start || x >= clip_rectangle.x_end) {
         return;
     }
@@ -214,6 +447,9 @@ void graphics_draw_vertical_line(int x, int y1, int y2, color_t color)
     int y_max = y1 < y2 ? y2 : y1;
     y_min = y_min < clip_rectangle.y_start ? clip_rectangle.y_start : y_min;
     y_max = y_max >= clip_rectangle.y_end ? clip_rectangle.y_end - 1 : y_max;
+    if (y_max >= y_min) {
+        mark_dirty_local(x, y_min, 1, y_max - y_min + 1);
+    }
     color_t *pixel = graphics_get_pixel(x, y_min);
     color_t *end_pixel = pixel + ((y_max - y_min) * canvas.width);
     while (pixel <= end_pixel) {
@@ -224,6 +460,10 @@ void graphics_draw_vertical_line(int x, int y1, int y2, color_t color)
 
 void graphics_draw_horizontal_line(int x1, int x2, int y, color_t color)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_HORIZONTAL_LINE, 0, x1, y, x2, 0, color);
+        return;
+    }
     if (y < clip_rectangle.y_start || y >= clip_rectangle.y_end) {
         return;
     }
@@ -231,6 +471,9 @@ void graphics_draw_horizontal_line(int x1, int x2, int y, color_t color)
     int x_max = x1 < x2 ? x2 : x1;
     x_min = x_min < clip_rectangle.x_start ? clip_rectangle.x_start : x_min;
     x_max = x_max >= clip_rectangle.x_end ? clip_rectangle.x_end - 1 : x_max;
+    if (x_max >= x_min) {
+        mark_dirty_local(x_min, y, x_max - x_min + 1, 1);
+    }
     color_t *pixel = graphics_get_pixel(x_min, y);
     color_t *end_pixel = pixel + (x_max - x_min);
     while (pixel <= end_pixel) {
@@ -257,6 +500,10 @@ void graphics_draw_inset_rect(int x, int y, int width, int height)
 
 void graphics_fill_rect(int x, int y, int width, int height, color_t color)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_FILL_RECT, 0, x, y, width, height, color);
+        return;
+    }
     for (int yy = y; yy < height + y; yy++) {
         graphics_draw_horizontal_line(x, x + width - 1, yy, color);
     }
@@ -264,6 +511,10 @@ void graphics_fill_rect(int x, int y, int width, int height, color_t color)
 
 void graphics_shade_rect(int x, int y, int width, int height, int darkness)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_SHADE_RECT, darkness, x, y, width, height, 0);
+        return;
+    }
     const clip_info *cur_clip = graphics_get_clip_info(x, y, width, height);
     if (!cur_clip->is_visible) {
         return;
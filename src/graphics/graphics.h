@@ -25,14 +25,98 @@ typedef struct {
     int is_visible;
 } clip_info;
 
+typedef struct {
+    int translation_x;
+    int translation_y;
+    int clip_x_start;
+    int clip_x_end;
+    int clip_y_start;
+    int clip_y_end;
+} graphics_state;
+
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} graphics_rect;
+
 void graphics_init_canvas(int width, int height);
 const void *graphics_canvas(void);
 
+/**
+ * Redirects drawing to a buffer that holds the given part of the screen.
+ * Coordinates stay screen coordinates, drawing is clipped to the buffer.
+ * @param pixels Buffer, width * height pixels
+ * @param x Screen x position of the buffer
+ * @param y Screen y position of the buffer
+ * @param width Width of the buffer
+ * @param height Height of the buffer
+ */
+void graphics_set_custom_canvas(color_t *pixels, int x, int y, int width, int height);
+
+/**
+ * Restores drawing to the screen after graphics_set_custom_canvas
+ */
+void graphics_restore_canvas(void);
+
+/**
+ * Saves the translation and clip rectangle of the current thread
+ * @param state State to save to
+ */
+void graphics_save_state(graphics_state *state);
+
+/**
+ * Restores the translation and clip rectangle of the current thread
+ * @param state State to restore
+ */
+void graphics_restore_state(const graphics_state *state);
+
+/**
+ * Limits drawing on the current thread to a band of screen rows,
+ * on top of any clip rectangle that is set
+ * @param y_start First row of the band
+ * @param y_end Row after the last row of the band
+ */
+void graphics_set_band(int y_start, int y_end);
+
+/**
+ * Removes the band limit set by graphics_set_band
+ */
+void graphics_clear_band(void);
+
+/**
+ * Marks part of the screen as changed. Drawing functions do this themselves,
+ * except when drawing in a band: the draw list marks the whole band area.
+ * @param x Screen x position
+ * @param y Screen y position
+ * @param width Width
+ * @param height Height
+ */
+void graphics_mark_dirty(int x, int y, int width, int height);
+
+/**
+ * Gets the parts of the screen that changed since the last graphics_clear_dirty_rects
+ * @param num_rects Set to the number of rectangles
+ * @return Rectangles in screen coordinates, they may overlap
+ */
+const graphics_rect *graphics_get_dirty_rects(int *num_rects);
+
+/**
+ * Forgets the changed parts of the screen, after they have been shown
+ */
+void graphics_clear_dirty_rects(void);
+
 void graphics_in_dialog(void);
 void graphics_reset_dialog(void);
 
 void graphics_set_clip_rectangle(int x, int y, int width, int height);
 void graphics_reset_clip_rectangle(void);
+/**
+ * Clips an area to the clip rectangle. The visible part is marked as changed,
+ * since callers draw into it.
+ * @return Clip info
+ */
 const clip_info *graphics_get_clip_info(int x, int y, int width, int height);
 
 void graphics_save_to_buffer(int x, int y, int width, int height, color_t *buffer);
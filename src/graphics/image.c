@@ -1,6 +1,8 @@
 #include "image.h"
 
 #include "core/log.h"
+#include "graphics/blit.h"
+#include "graphics/draw_list.h"
 #include "graphics/graphics.h"
 #include "graphics/screen.h"
 
@@ -31,6 +33,18 @@ static const int FOOTPRINT_OFFSET_PER_HEIGHT[] = {
     508, 562, 612, 658, 700, 738, 772, 802, 828, 850, 868, 882, 892, 898
 };
 
+// Clips a run of pixels starting at x to the visible columns of the image
+static int clip_run(const clip_info *clip, int width, int x, int length, int *skip)
+{
+    int start = x < clip->clipped_pixels_left ? clip->clipped_pixels_left : x;
+    int end = x + length;
+    if (end > width - clip->clipped_pixels_right) {
+        end = width - clip->clipped_pixels_right;
+    }
+    *skip = start - x;
+    return end > start ? end - start : 0;
+}
+
 static void draw_uncompressed(
     const image *img, const color_t *data, int x_offset, int y_offset, color_t color, draw_type type)
 {
@@ -45,12 +59,9 @@ static void draw_uncompressed(
         int x_max = img->width - clip->clipped_pixels_right;
         if (type == DRAW_TYPE_NONE) {
             if (img->draw.type == IMAGE_TYPE_WITH_TRANSPARENCY || img->draw.is_external) { // can be transparent
-                for (int x = clip->clipped_pixels_left; x < x_max; x++, dst++) {
-                    if (*data != COLOR_SG2_TRANSPARENT) {
-                        *dst = *data;
-                    }
-                    data++;
-                }
+                int num_pixels = x_max - clip->clipped_pixels_left;
+                blit_get_functions()->copy_opaque(dst, data, num_pixels);
+                data += num_pixels;
             } else {
                 int num_pixels = x_max - clip->clipped_pixels_left;
                 memcpy(dst, data, num_pixels * sizeof(color_t));
@@ -122,19 +133,15 @@ static void draw_compressed(const image *img, const color_t *data, int x_offset,
                 data += b;
                 color_t *dst = graphics_get_pixel(x_offset + x, y_offset + y);
                 if (unclipped) {
-                    x += b;
                     memcpy(dst, pixels, b * sizeof(color_t));
                 } else {
-                    while (b) {
-                        if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
-                            *dst = *pixels;
-                        }
-                        dst++;
-                        x++;
-                        pixels++;
-                        b--;
+                    int skip;
+                    int visible = clip_run(clip, img->width, x, b, &skip);
+                    if (visible) {
+                        memcpy(dst + skip, pixels + skip, visible * sizeof(color_t));
                     }
                 }
+                x += b;
             }
         }
     }
@@ -147,6 +154,7 @@ static void draw_compressed_set(
     if (!clip->is_visible) {
         return;
     }
+    const blit_functions *blit = blit_get_functions();
     int unclipped = clip->clip_x == CLIP_NONE;
 
     for (int y = 0; y < height - clip->clipped_pixels_bottom; y++) {
@@ -165,22 +173,13 @@ static void draw_compressed_set(
                 data += b;
                 color_t *dst = graphics_get_pixel(x_offset + x, y_offset + y);
                 if (unclipped) {
-                    x += b;
-                    while (b) {
-                        *dst = color;
-                        dst++;
-                        b--;
-                    }
+                    blit->fill(dst, color, b);
                 } else {
-                    while (b) {
-                        if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
-                            *dst = color;
-                        }
-                        dst++;
-                        x++;
-                        b--;
-                    }
+                    int skip;
+                    int visible = clip_run(clip, img->width, x, b, &skip);
+                    blit->fill(dst + skip, color, visible);
                 }
+                x += b;
             }
         }
     }
@@ -193,6 +192,7 @@ static void draw_compressed_and(
     if (!clip->is_visible) {
         return;
     }
+    const blit_functions *blit = blit_get_functions();
     int unclipped = clip->clip_x == CLIP_NONE;
 
     for (int y = 0; y < height - clip->clipped_pixels_bottom; y++) {
@@ -213,24 +213,13 @@ static void draw_compressed_and(
                 data += b;
                 color_t *dst = graphics_get_pixel(x_offset + x, y_offset + y);
                 if (unclipped) {
-                    x += b;
-                    while (b) {
-                        *dst = *pixels & color;
-                        dst++;
-                        pixels++;
-                        b--;
-                    }
+                    blit->copy_masked(dst, pixels, color, b);
                 } else {
-                    while (b) {
-                        if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
-                            *dst = *pixels & color;
-                        }
-                        dst++;
-                        x++;
-                        pixels++;
-                        b--;
-                    }
+                    int skip;
+                    int visible = clip_run(clip, img->width, x, b, &skip);
+                    blit->copy_masked(dst + skip, pixels + skip, color, visible);
                 }
+                x += b;
             }
         }
     }
@@ -243,6 +232,7 @@ static void draw_compressed_blend(
     if (!clip->is_visible) {
         return;
     }
+    const blit_functions *blit = blit_get_functions();
     int unclipped = clip->clip_x == CLIP_NONE;
 
     for (int y = 0; y < height - clip->clipped_pixels_bottom; y++) {
@@ -261,22 +251,13 @@ static void draw_compressed_blend(
                 data += b;
                 color_t *dst = graphics_get_pixel(x_offset + x, y_offset + y);
                 if (unclipped) {
-                    x += b;
-                    while (b) {
-                        *dst &= color;
-                        dst++;
-                        b--;
-                    }
+                    blit->mask(dst, color, b);
                 } else {
-                    while (b) {
-                        if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
-                            *dst &= color;
-                        }
-                        dst++;
-                        x++;
-                        b--;
-                    }
+                    int skip;
+                    int visible = clip_run(clip, img->width, x, b, &skip);
+                    blit->mask(dst + skip, color, visible);
                 }
+                x += b;
             }
         }
     }
@@ -297,9 +278,7 @@ static void draw_compressed_blend_alpha(
         draw_compressed_set(img, data, x_offset, y_offset, height, color);
         return;
     }
-    color_t alpha_dst = 256 - alpha;
-    color_t src_rb = (color & 0xff00ff) * alpha;
-    color_t src_g = (color & 0x00ff00) * alpha;
+    const blit_functions *blit = blit_get_functions();
     int unclipped = clip->clip_x == CLIP_NONE;
 
     for (int y = 0; y < height - clip->clipped_pixels_bottom; y++) {
@@ -320,26 +299,14 @@ static void draw_compressed_blend_alpha(
             } else {
                 data += b;
                 if (unclipped) {
-                    x += b;
-                    while (b) {
-                        color_t d = *dst;
-                        *dst = (((src_rb + (d & 0xff00ff) * alpha_dst) & 0xff00ff00) |
-                                ((src_g  + (d & 0x00ff00) * alpha_dst) & 0x00ff0000)) >> 8;
-                        b--;
-                        dst++;
-                    }
+                    blit->blend_alpha(dst, color, b);
                 } else {
-                    while (b) {
-                        if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
-                            color_t d = *dst;
-                            *dst = (((src_rb + (d & 0xff00ff) * alpha_dst) & 0xff00ff00) |
-                                   ((src_g  + (d & 0x00ff00) * alpha_dst) & 0x00ff0000)) >> 8;
-                        }
-                        dst++;
-                        x++;
-                        b--;
-                    }
+                    int skip;
+                    int visible = clip_run(clip, img->width, x, b, &skip);
+                    blit->blend_alpha(dst + skip, color, visible);
                 }
+                x += b;
+                dst += b;
             }
         }
     }
@@ -433,10 +400,8 @@ static void draw_footprint_tile(const color_t *data, int x_offset, int y_offset,
             memcpy(buffer, src, x_max * sizeof(color_t));
             src += x_max + x_pixel_advance;
         } else {
-            for (int x = 0; x < x_max; x++, buffer++, src++) {
-                *buffer = *src & color_mask;
-            }
-            src += x_pixel_advance;
+            blit_get_functions()->copy_masked(buffer, src, color_mask, x_max);
+            src += x_max + x_pixel_advance;
         }
     }
 }
@@ -557,6 +522,10 @@ static void draw_footprint_size5(int image_id, int x, int y, color_t color_mask)
 
 void image_draw(int image_id, int x, int y)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IMAGE, image_id, x, y, 0, 0, 0);
+        return;
+    }
     const image *img = image_get(image_id);
     const color_t *data = image_data(image_id);
     if (!data) {
@@ -572,6 +541,10 @@ void image_draw(int image_id, int x, int y)
 
 void image_draw_enemy(int image_id, int x, int y)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IMAGE_ENEMY, image_id, x, y, 0, 0, 0);
+        return;
+    }
     if (image_id <= 0 || image_id >= 801) {
         return;
     }
@@ -584,6 +557,10 @@ void image_draw_enemy(int image_id, int x, int y)
 
 void image_draw_masked(int image_id, int x, int y, color_t color_mask)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IMAGE_MASKED, image_id, x, y, 0, 0, color_mask);
+        return;
+    }
     const image *img = image_get(image_id);
     const color_t *data = image_data(image_id);
     if (!data) {
@@ -609,6 +586,10 @@ void image_draw_masked(int image_id, int x, int y, color_t color_mask)
 
 void image_draw_blend(int image_id, int x, int y, color_t color)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IMAGE_BLEND, image_id, x, y, 0, 0, color);
+        return;
+    }
     const image *img = image_get(image_id);
     const color_t *data = image_data(image_id);
     if (!data) {
@@ -628,6 +609,10 @@ void image_draw_blend(int image_id, int x, int y, color_t color)
 
 void image_draw_blend_alpha(int image_id, int x, int y, color_t color)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IMAGE_BLEND_ALPHA, image_id, x, y, 0, 0, color);
+        return;
+    }
     const image *img = image_get(image_id);
     const color_t *data = image_data(image_id);
     if (!data) {
@@ -673,6 +658,10 @@ static void draw_multibyte_letter(font_t font, const image *img, const color_t *
 
 void image_draw_letter(font_t font, int letter_id, int x, int y, color_t color)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_LETTER, letter_id, x, y, font, 0, color);
+        return;
+    }
     const image *img = image_letter(letter_id);
     const color_t *data = image_data_letter(letter_id);
     if (!data) {
@@ -707,6 +696,10 @@ void image_draw_fullscreen_background(int image_id)
 
 void image_draw_isometric_footprint(int image_id, int x, int y, color_t color_mask)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_ISOMETRIC_FOOTPRINT, image_id, x, y, 0, 0, color_mask);
+        return;
+    }
     const image *img = image_get(image_id);
     if (img->draw.type != IMAGE_TYPE_ISOMETRIC) {
         return;
@@ -732,6 +725,10 @@ void image_draw_isometric_footprint(int image_id, int x, int y, color_t color_ma
 
 void image_draw_isometric_footprint_from_draw_tile(int image_id, int x, int y, color_t color_mask)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_ISOMETRIC_FOOTPRINT_FROM_DRAW_TILE, image_id, x, y, 0, 0, color_mask);
+        return;
+    }
     const image *img = image_get(image_id);
     if (img->draw.type != IMAGE_TYPE_ISOMETRIC) {
         return;
@@ -757,6 +754,10 @@ void image_draw_isometric_footprint_from_draw_tile(int image_id, int x, int y, c
 
 void image_draw_isometric_top(int image_id, int x, int y, color_t color_mask)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_ISOMETRIC_TOP, image_id, x, y, 0, 0, color_mask);
+        return;
+    }
     const image *img = image_get(image_id);
     if (img->draw.type != IMAGE_TYPE_ISOMETRIC) {
         return;
@@ -802,6 +803,10 @@ void image_draw_isometric_top(int image_id, int x, int y, color_t color_mask)
 
 void image_draw_isometric_top_from_draw_tile(int image_id, int x, int y, color_t color_mask)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_ISOMETRIC_TOP_FROM_DRAW_TILE, image_id, x, y, 0, 0, color_mask);
+        return;
+    }
     const image *img = image_get(image_id);
     if (img->draw.type != IMAGE_TYPE_ISOMETRIC) {
         return;
@@ -880,6 +885,10 @@ static color_t color_average(const image *img, const color_t *data, int x, int y
 
 void image_draw_scaled_down(int image_id, int x_offset, int y_offset, unsigned int scale_factor)
 {
+    if (draw_list_is_recording()) {
+        draw_list_add(DRAW_COMMAND_IMAGE_SCALED_DOWN, image_id, x_offset, y_offset, scale_factor, 0, 0);
+        return;
+    }
     const image *img = image_get(image_id);
     const color_t *data = image_data(image_id);
 
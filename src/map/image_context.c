@@ -324,29 +324,42 @@ static int context_matches_tiles(const struct terrain_image_context *context, co
     return 1;
 }
 
-static const terrain_image *get_image(int group, int tiles[MAX_TILES])
+static int find_context(int group, const int tiles[MAX_TILES])
 {
-    static terrain_image result;
-
-    result.is_valid = 0;
-    struct terrain_image_context *context = context_pointers[group].context;
+    const struct terrain_image_context *context = context_pointers[group].context;
     int size = context_pointers[group].size;
     for (int i = 0; i < size; i++) {
         if (context_matches_tiles(&context[i], tiles)) {
-            context[i].current_item_offset++;
-            if (context[i].current_item_offset >= context[i].max_item_offset) {
-                context[i].current_item_offset = 0;
-            }
-            result.is_valid = 1;
-            result.group_offset = context[i].offset_for_orientation[city_view_orientation() / 2];
-            result.item_offset = context[i].current_item_offset;
-            result.aqueduct_offset = context[i].aqueduct_offset;
-            break;
+            return i;
         }
     }
+    return -1;
+}
+
+static const terrain_image *get_image_for_context(int group, int index)
+{
+    static terrain_image result;
+
+    result.is_valid = 0;
+    if (index >= 0) {
+        struct terrain_image_context *context = &context_pointers[group].context[index];
+        context->current_item_offset++;
+        if (context->current_item_offset >= context->max_item_offset) {
+            context->current_item_offset = 0;
+        }
+        result.is_valid = 1;
+        result.group_offset = context->offset_for_orientation[city_view_orientation() / 2];
+        result.item_offset = context->current_item_offset;
+        result.aqueduct_offset = context->aqueduct_offset;
+    }
     return &result;
 }
 
+static const terrain_image *get_image(int group, int tiles[MAX_TILES])
+{
+    return get_image_for_context(group, find_context(group, tiles));
+}
+
 const terrain_image *map_image_context_get_elevation(int grid_offset, int elevation)
 {
     int tiles[MAX_TILES];
@@ -375,10 +388,20 @@ static void fill_matches(int grid_offset, int terrain, int match_value, int no_m
 }
 
 const terrain_image *map_image_context_get_shore(int grid_offset)
+{
+    return map_image_context_get_shore_for_context(map_image_context_find_shore(grid_offset));
+}
+
+int map_image_context_find_shore(int grid_offset)
 {
     int tiles[MAX_TILES];
     fill_matches(grid_offset, TERRAIN_WATER, 0, 1, tiles);
-    return get_image(CONTEXT_WATER, tiles);
+    return find_context(CONTEXT_WATER, tiles);
+}
+
+const terrain_image *map_image_context_get_shore_for_context(int context)
+{
+    return get_image_for_context(CONTEXT_WATER, context);
 }
 
 const terrain_image *map_image_context_get_wall(int grid_offset)
@@ -15,6 +15,21 @@ void map_image_context_reset_elevation(void);
 const terrain_image *map_image_context_get_elevation(int grid_offset, int elevation);
 const terrain_image *map_image_context_get_earthquake(int grid_offset);
 const terrain_image *map_image_context_get_shore(int grid_offset);
+
+/**
+ * Finds the shore context of a tile without advancing its image variant
+ * @param grid_offset Tile
+ * @return Context to pass to map_image_context_get_shore_for_context
+ */
+int map_image_context_find_shore(int grid_offset);
+
+/**
+ * Gets the shore image for a context found earlier, advancing its image variant
+ * exactly like map_image_context_get_shore does
+ * @param context Context from map_image_context_find_shore
+ * @return Shore image
+ */
+const terrain_image *map_image_context_get_shore_for_context(int context);
 const terrain_image *map_image_context_get_wall(int grid_offset);
 const terrain_image *map_image_context_get_wall_gatehouse(int grid_offset);
 const terrain_image *map_image_context_get_dirt_road(int grid_offset);
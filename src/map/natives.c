@@ -53,10 +53,9 @@ static void determine_meeting_center(void)
 {
     // gather list of meeting centers
     building_list_small_clear();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_NATIVE_MEETING) {
-            building_list_small_add(i);
+    for (building *b = building_first_of_type(BUILDING_NATIVE_MEETING); b; b = building_next_of_type(b)) {
+        if (b->state == BUILDING_STATE_IN_USE) {
+            building_list_small_add(b->id);
         }
     }
     int total_meetings = building_list_small_size();
@@ -65,9 +64,8 @@ static void determine_meeting_center(void)
     }
     const int *meetings = building_list_small_items();
     // determine closest meeting center for hut
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_NATIVE_HUT) {
+    for (building *b = building_first_of_type(BUILDING_NATIVE_HUT); b; b = building_next_of_type(b)) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             int min_dist = 1000;
             int min_meeting_id = 0;
             for (int n = 0; n < total_meetings; n++) {
@@ -199,7 +197,7 @@ void map_natives_check_land(void)
     map_property_clear_all_native_land();
     city_military_decrease_native_attack_duration();
 
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
@@ -6,14 +6,24 @@
 #include "map/grid.h"
 #include "map/road_aqueduct.h"
 #include "map/routing_data.h"
+#include "map/routing_terrain.h"
 #include "map/terrain.h"
 
+#include <string.h>
+
 #define MAX_QUEUE GRID_SIZE * GRID_SIZE
 #define GUARD 50000
 
 #define UNTIL_STOP 0
 #define UNTIL_CONTINUE 1
 
+#define MAX_CACHED_DISTANCES 8
+#define NO_SOURCE -1
+
+// every expanded tile pushes at most four neighbours
+#define MAX_GOAL_QUEUE (4 * MAX_QUEUE + 1)
+#define MAX_GOAL_F (MAX_QUEUE + 2 * GRID_SIZE)
+
 static const int ROUTE_OFFSETS[] = {-162, 1, 162, -1, -161, 163, 161, -163};
 
 static grid_i16 routing_distance;
@@ -31,18 +41,90 @@ static struct {
 
 static grid_u8 water_drag;
 
+static struct {
+    int items[MAX_QUEUE];
+    int size;
+    int all;
+} touched;
+
 static struct {
     int through_building_id;
 } state;
 
+typedef struct {
+    int dist;
+    int offset;
+    int next;
+} goal_item;
+
+static struct {
+    int active;
+    int dest_x;
+    int dest_y;
+    void (*callback)(int next_offset, int dist);
+    int size;
+    goal_item items[MAX_GOAL_QUEUE];
+    int buckets[MAX_GOAL_F];
+    int current_f;
+    int max_f;
+    grid_i16 open_distance;
+} goal_queue;
+
+typedef struct {
+    int source;
+    int generation;
+    int last_used;
+    grid_i16 distances;
+} cached_distances;
+
+static struct {
+    cached_distances entries[MAX_CACHED_DISTANCES];
+    int use_counter;
+    int current_source;
+    int current_generation;
+} distance_cache;
+
+static void invalidate_current_distances(void)
+{
+    distance_cache.current_source = NO_SOURCE;
+}
+
 static void clear_distances(void)
 {
-    map_grid_clear_i16(routing_distance.items);
+    if (touched.all) {
+        map_grid_clear_i16(routing_distance.items);
+    } else {
+        for (int i = 0; i < touched.size; i++) {
+            routing_distance.items[touched.items[i]] = 0;
+        }
+    }
+    touched.size = 0;
+    touched.all = 0;
+    invalidate_current_distances();
+    goal_queue.active = 0;
 }
 
+static void set_distance(int grid_offset, int dist)
+{
+    if (!routing_distance.items[grid_offset]) {
+        if (touched.size < MAX_QUEUE) {
+            touched.items[touched.size++] = grid_offset;
+        } else {
+            touched.all = 1;
+        }
+    }
+    routing_distance.items[grid_offset] = dist;
+}
+
+static void goal_enqueue(int next_offset, int dist);
+
 static void enqueue(int next_offset, int dist)
 {
-    routing_distance.items[next_offset] = dist;
+    if (goal_queue.active) {
+        goal_enqueue(next_offset, dist);
+        return;
+    }
+    set_distance(next_offset, dist);
     queue.items[queue.tail++] = next_offset;
     if (queue.tail >= MAX_QUEUE) {
         queue.tail = 0;
@@ -122,7 +204,6 @@ static void route_queue_max(int source, int dest, int max_tiles, void (*callback
 static void route_queue_boat(int source, void (*callback)(int, int))
 {
     clear_distances();
-    map_grid_clear_u8(water_drag.items);
     queue.head = queue.tail = 0;
     enqueue(source, 1);
     int tiles = 0;
@@ -149,6 +230,13 @@ static void route_queue_boat(int source, void (*callback)(int, int))
             queue.head = 0;
         }
     }
+    // only visited tiles can have drag, so reset those for the next search
+    for (int i = 0; i < touched.size; i++) {
+        water_drag.items[touched.items[i]] = 0;
+    }
+    if (touched.all) {
+        map_grid_clear_u8(water_drag.items);
+    }
 }
 
 static void route_queue_dir8(int source, void (*callback)(int, int))
@@ -174,6 +262,130 @@ static void route_queue_dir8(int source, void (*callback)(int, int))
     }
 }
 
+static int goal_heuristic(int grid_offset)
+{
+    int dx = grid_offset % GRID_SIZE - goal_queue.dest_x;
+    int dy = grid_offset / GRID_SIZE - goal_queue.dest_y;
+    return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+}
+
+static void goal_enqueue(int next_offset, int dist)
+{
+    // the heuristic is consistent, so f never drops below the bucket currently being expanded
+    int f = dist + goal_heuristic(next_offset);
+    goal_item *item = &goal_queue.items[goal_queue.size];
+    item->dist = dist;
+    item->offset = next_offset;
+    item->next = goal_queue.buckets[f];
+    goal_queue.buckets[f] = ++goal_queue.size;
+    if (f > goal_queue.max_f) {
+        goal_queue.max_f = f;
+    }
+    goal_queue.open_distance.items[next_offset] = dist;
+}
+
+static const goal_item *goal_peek(void)
+{
+    while (goal_queue.current_f <= goal_queue.max_f) {
+        int index = goal_queue.buckets[goal_queue.current_f];
+        if (!index) {
+            goal_queue.current_f++;
+            continue;
+        }
+        const goal_item *item = &goal_queue.items[index - 1];
+        if (!routing_distance.items[item->offset] &&
+            goal_queue.open_distance.items[item->offset] == item->dist) {
+            return item;
+        }
+        // tile already done or reached through a shorter path since this item was queued
+        goal_queue.buckets[goal_queue.current_f] = item->next;
+    }
+    return 0;
+}
+
+static int goal_expand_next(void)
+{
+    const goal_item *top = goal_peek();
+    if (!top) {
+        goal_queue.active = 0;
+        return -1;
+    }
+    int offset = top->offset;
+    int dist = top->dist;
+    goal_queue.buckets[goal_queue.current_f] = top->next;
+    set_distance(offset, dist);
+    for (int i = 0; i < 4; i++) {
+        int next_offset = offset + ROUTE_OFFSETS[i];
+        if (!map_grid_is_valid_offset(next_offset) || routing_distance.items[next_offset]) {
+            continue;
+        }
+        int open_distance = goal_queue.open_distance.items[next_offset];
+        if (!open_distance) {
+            goal_queue.callback(next_offset, dist + 1);
+        } else if (dist + 1 < open_distance) {
+            goal_enqueue(next_offset, dist + 1);
+        }
+    }
+    return offset;
+}
+
+/**
+ * A* search with Manhattan distance heuristic.
+ *
+ * Only tiles that have been expanded get their distance set, and those distances are
+ * the same as a full flood would produce. The search is paused once the destination is
+ * reached; map_routing_finalize_distances_around() resumes it when the path is traced back,
+ * so the resulting path is identical to the one found using route_queue().
+ */
+static void route_queue_goal(int source, int dest, void (*callback)(int next_offset, int dist))
+{
+    clear_distances();
+    for (int i = 0; i < goal_queue.size; i++) {
+        goal_queue.open_distance.items[goal_queue.items[i].offset] = 0;
+    }
+    memset(goal_queue.buckets, 0, (goal_queue.max_f + 1) * sizeof(int));
+    goal_queue.size = 0;
+    goal_queue.current_f = 0;
+    goal_queue.max_f = 0;
+    goal_queue.dest_x = dest % GRID_SIZE;
+    goal_queue.dest_y = dest / GRID_SIZE;
+    goal_queue.callback = callback;
+    goal_queue.active = 1;
+    enqueue(source, 1);
+    int offset;
+    do {
+        offset = goal_expand_next();
+    } while (offset >= 0 && offset != dest);
+}
+
+void map_routing_finalize_distances_around(int grid_offset)
+{
+    if (!goal_queue.active) {
+        return;
+    }
+    int distance = routing_distance.items[grid_offset];
+    for (int i = 0; i < 8; i++) {
+        int next_offset = grid_offset + ROUTE_OFFSETS[i];
+        if (!map_grid_is_valid_offset(next_offset)) {
+            continue;
+        }
+        int heuristic = goal_heuristic(next_offset);
+        while (!routing_distance.items[next_offset]) {
+            const goal_item *top = goal_peek();
+            if (!top) {
+                // all reachable tiles have their final distance
+                goal_queue.active = 0;
+                return;
+            }
+            if (goal_queue.current_f - heuristic >= distance) {
+                // tile cannot be closer to the source than the current one
+                break;
+            }
+            goal_expand_next();
+        }
+    }
+}
+
 static void callback_calc_distance(int next_offset, int dist)
 {
     if (terrain_land_citizen.items[next_offset] >= CITIZEN_0_ROAD) {
@@ -181,10 +393,51 @@ static void callback_calc_distance(int next_offset, int dist)
     }
 }
 
+static cached_distances *get_cached_distances(int source, int generation)
+{
+    for (int i = 0; i < MAX_CACHED_DISTANCES; i++) {
+        cached_distances *entry = &distance_cache.entries[i];
+        if (entry->last_used && entry->source == source && entry->generation == generation) {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+static cached_distances *get_least_recently_used_cache_entry(void)
+{
+    cached_distances *lru = &distance_cache.entries[0];
+    for (int i = 1; i < MAX_CACHED_DISTANCES; i++) {
+        if (distance_cache.entries[i].last_used < lru->last_used) {
+            lru = &distance_cache.entries[i];
+        }
+    }
+    return lru;
+}
+
 void map_routing_calculate_distances(int x, int y)
 {
     ++stats.total_routes_calculated;
-    route_queue(map_grid_offset(x, y), -1, callback_calc_distance);
+    int source = map_grid_offset(x, y);
+    int generation = map_routing_land_citizen_generation();
+    if (distance_cache.current_source == source && distance_cache.current_generation == generation) {
+        // routing_distance still holds this exact field
+        return;
+    }
+    cached_distances *entry = get_cached_distances(source, generation);
+    if (entry) {
+        memcpy(routing_distance.items, entry->distances.items, sizeof(routing_distance.items));
+        touched.all = 1;
+    } else {
+        route_queue(source, -1, callback_calc_distance);
+        entry = get_least_recently_used_cache_entry();
+        entry->source = source;
+        entry->generation = generation;
+        memcpy(entry->distances.items, routing_distance.items, sizeof(routing_distance.items));
+    }
+    entry->last_used = ++distance_cache.use_counter;
+    distance_cache.current_source = source;
+    distance_cache.current_generation = generation;
 }
 
 static void callback_calc_distance_water_boat(int next_offset, int dist)
@@ -238,7 +491,7 @@ static void callback_calc_distance_build_road(int next_offset, int dist)
     switch (terrain_land_citizen.items[next_offset]) {
         case CITIZEN_N3_AQUEDUCT:
             if (!map_can_place_road_under_aqueduct(next_offset)) {
-                routing_distance.items[next_offset] = -1;
+                set_distance(next_offset, -1);
                 blocked = 1;
             }
             break;
@@ -275,7 +528,7 @@ static void callback_calc_distance_build_aqueduct(int next_offset, int dist)
             break;
     }
     if (map_terrain_is(next_offset, TERRAIN_ROAD) && !map_can_place_aqueduct_on_road(next_offset)) {
-        routing_distance.items[next_offset] = -1;
+        set_distance(next_offset, -1);
         blocked = 1;
     }
     if (!blocked) {
@@ -392,7 +645,7 @@ int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, in
     int src_offset = map_grid_offset(src_x, src_y);
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
-    route_queue(src_offset, dst_offset, callback_travel_citizen_land);
+    route_queue_goal(src_offset, dst_offset, callback_travel_citizen_land);
     return routing_distance.items[dst_offset] != 0;
 }
 
@@ -409,7 +662,7 @@ int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int ds
     int src_offset = map_grid_offset(src_x, src_y);
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
-    route_queue(src_offset, dst_offset, callback_travel_citizen_road_garden);
+    route_queue_goal(src_offset, dst_offset, callback_travel_citizen_road_garden);
     return routing_distance.items[dst_offset] != 0;
 }
 
@@ -426,7 +679,7 @@ int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y
     int src_offset = map_grid_offset(src_x, src_y);
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
-    route_queue(src_offset, dst_offset, callback_travel_walls);
+    route_queue_goal(src_offset, dst_offset, callback_travel_walls);
     return routing_distance.items[dst_offset] != 0;
 }
 
@@ -461,7 +714,7 @@ int map_routing_noncitizen_can_travel_over_land(
     ++stats.enemy_routes_calculated;
     if (only_through_building_id) {
         state.through_building_id = only_through_building_id;
-        route_queue(src_offset, dst_offset, callback_travel_noncitizen_land_through_building);
+        route_queue_goal(src_offset, dst_offset, callback_travel_noncitizen_land_through_building);
     } else {
         route_queue_max(src_offset, dst_offset, max_tiles, callback_travel_noncitizen_land);
     }
@@ -480,7 +733,7 @@ int map_routing_noncitizen_can_travel_through_everything(int src_x, int src_y, i
     int src_offset = map_grid_offset(src_x, src_y);
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
-    route_queue(src_offset, dst_offset, callback_travel_noncitizen_through_everything);
+    route_queue_goal(src_offset, dst_offset, callback_travel_noncitizen_through_everything);
     return routing_distance.items[dst_offset] != 0;
 }
 
@@ -489,6 +742,7 @@ void map_routing_block(int x, int y, int size)
     if (!map_grid_is_inside(x, y, size)) {
         return;
     }
+    invalidate_current_distances();
     for (int dy = 0; dy < size; dy++) {
         for (int dx = 0; dx < size; dx++) {
             routing_distance.items[map_grid_offset(x+dx, y+dy)] = 0;
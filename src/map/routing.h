@@ -20,6 +20,13 @@ void map_routing_delete_first_wall_or_aqueduct(int x, int y);
 
 int map_routing_distance(int grid_offset);
 
+/**
+ * Makes sure the distances of all tiles around the given tile that are closer to the source
+ * are final. Must be called for every tile when tracing back a path after a point-to-point route
+ * @param grid_offset Tile that has a distance set
+ */
+void map_routing_finalize_distances_around(int grid_offset);
+
 int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, int dst_y);
 int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int dst_x, int dst_y);
 int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y);
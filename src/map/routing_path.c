@@ -8,7 +8,7 @@
 
 #define MAX_PATH 500
 
-static int direction_path[MAX_PATH];
+static uint8_t direction_path[GRID_SIZE * GRID_SIZE];
 
 static void adjust_tile_in_direction(int direction, int *x, int *y, int *grid_offset)
 {
@@ -45,7 +45,7 @@ static void adjust_tile_in_direction(int direction, int *x, int *y, int *grid_of
     *grid_offset += map_grid_direction_delta(direction);
 }
 
-int map_routing_get_path(uint8_t *path, int src_x, int src_y, int dst_x, int dst_y, int num_directions)
+int map_routing_get_path(uint8_t *path, int max_length, int src_x, int src_y, int dst_x, int dst_y, int num_directions)
 {
     int dst_grid_offset = map_grid_offset(dst_x, dst_y);
     int distance = map_routing_distance(dst_grid_offset);
@@ -62,6 +62,7 @@ int map_routing_get_path(uint8_t *path, int src_x, int src_y, int dst_x, int dst
 
     while (distance > 1) {
         distance = map_routing_distance(grid_offset);
+        map_routing_finalize_distances_around(grid_offset);
         int direction = -1;
         int general_direction = calc_general_direction(x, y, src_x, src_y);
         for (int d = 0; d < 8; d += step) {
@@ -86,7 +87,7 @@ int map_routing_get_path(uint8_t *path, int src_x, int src_y, int dst_x, int dst
         int forward_direction = (direction + 4) % 8;
         direction_path[num_tiles++] = forward_direction;
         last_direction = forward_direction;
-        if (num_tiles >= MAX_PATH) {
+        if (num_tiles >= max_length) {
             return 0;
         }
     }
@@ -114,6 +115,7 @@ int map_routing_get_closest_tile_within_range(
 
     while (distance > 1) {
         distance = map_routing_distance(grid_offset);
+        map_routing_finalize_distances_around(grid_offset);
         *out_x = x;
         *out_y = y;
         if (distance <= range) {
@@ -150,7 +152,7 @@ int map_routing_get_closest_tile_within_range(
     return 0;
 }
 
-int map_routing_get_path_on_water(uint8_t *path, int dst_x, int dst_y, int is_flotsam)
+int map_routing_get_path_on_water(uint8_t *path, int max_length, int dst_x, int dst_y, int is_flotsam)
 {
     int rand = random_byte() & 3;
     int dst_grid_offset = map_grid_offset(dst_x, dst_y);
@@ -194,7 +196,7 @@ int map_routing_get_path_on_water(uint8_t *path, int dst_x, int dst_y, int is_fl
         int forward_direction = (direction + 4) % 8;
         direction_path[num_tiles++] = forward_direction;
         last_direction = forward_direction;
-        if (num_tiles >= MAX_PATH) {
+        if (num_tiles >= max_length) {
             return 0;
         }
     }
@@ -3,9 +3,21 @@
 
 #include <stdint.h>
 
-int map_routing_get_path(uint8_t *path, int src_x, int src_y, int dst_x, int dst_y, int num_directions);
+/**
+ * Traces back the path from the destination to the source of the last distance calculation
+ * @param path Buffer to store the directions in, must be able to hold max_length directions
+ * @param max_length Maximum number of tiles, longer paths are rejected
+ * @return Number of directions in the path, 0 if no path was found
+ */
+int map_routing_get_path(uint8_t *path, int max_length, int src_x, int src_y, int dst_x, int dst_y, int num_directions);
 
-int map_routing_get_path_on_water(uint8_t *path, int dst_x, int dst_y, int is_flotsam);
+/**
+ * Traces back the path over water from the destination to the source of the last distance calculation
+ * @param path Buffer to store the directions in, must be able to hold max_length directions
+ * @param max_length Maximum number of tiles, longer paths are rejected
+ * @return Number of directions in the path, 0 if no path was found
+ */
+int map_routing_get_path_on_water(uint8_t *path, int max_length, int dst_x, int dst_y, int is_flotsam);
 
 int map_routing_get_closest_tile_within_range(
     int src_x, int src_y, int dst_x, int dst_y, int num_directions, int range, int *out_x, int *out_y);
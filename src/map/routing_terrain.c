@@ -15,6 +15,8 @@
 
 static void map_routing_update_land_noncitizen(void);
 
+static int land_citizen_generation = 1;
+
 void map_routing_update_all(void)
 {
     map_routing_update_land();
@@ -108,6 +110,7 @@ static int get_land_type_citizen_aqueduct(int grid_offset)
 
 void map_routing_update_land_citizen(void)
 {
+    land_citizen_generation++;
     map_grid_init_i8(terrain_land_citizen.items, -1);
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
@@ -139,6 +142,11 @@ void map_routing_update_land_citizen(void)
     }
 }
 
+int map_routing_land_citizen_generation(void)
+{
+    return land_citizen_generation;
+}
+
 static int get_land_type_noncitizen(int grid_offset)
 {
     int type = NONCITIZEN_1_BUILDING;
@@ -28,6 +28,10 @@
             TERRAIN_ROAD | TERRAIN_BUILDING | TERRAIN_GARDEN)
 
 static int aqueduct_include_construction = 0;
+static struct {
+    int8_t shore_context[GRID_SIZE * GRID_SIZE];
+    uint8_t is_fortified[GRID_SIZE * GRID_SIZE];
+} water_tiles;
 static int elevation_recalculate_trees = 0;
 
 static int is_clear(int x, int y, int size, int disallowed_terrain, int check_image)
@@ -862,30 +866,40 @@ void map_tiles_update_region_meadow(int x_min, int y_min, int x_max, int y_max)
     foreach_region_tile(x_min, y_min, x_max, y_max, update_meadow_tile);
 }
 
+static int is_water_tile(int grid_offset)
+{
+    return (map_terrain_get(grid_offset) & (TERRAIN_WATER | TERRAIN_BUILDING)) == TERRAIN_WATER;
+}
+
+static int get_water_image_id(const terrain_image *img, int is_fortified)
+{
+    int image_id = image_group(GROUP_TERRAIN_WATER) + img->group_offset + img->item_offset;
+    if (is_fortified) {
+        int base = image_group(GROUP_TERRAIN_WATER_SHORE);
+        switch (img->group_offset) {
+            case 8: image_id = base + 10; break;
+            case 12: image_id = base + 11; break;
+            case 16: image_id = base + 9; break;
+            case 20: image_id = base + 8; break;
+            case 24: image_id = base + 18; break;
+            case 28: image_id = base + 16; break;
+            case 32: image_id = base + 19; break;
+            case 36: image_id = base + 17; break;
+            case 50: image_id = base + 12; break;
+            case 51: image_id = base + 14; break;
+            case 52: image_id = base + 13; break;
+            case 53: image_id = base + 15; break;
+        }
+    }
+    return image_id;
+}
+
 static void set_water_image(int x, int y, int grid_offset)
 {
-    if ((map_terrain_get(grid_offset) & (TERRAIN_WATER | TERRAIN_BUILDING)) == TERRAIN_WATER) {
+    if (is_water_tile(grid_offset)) {
         const terrain_image *img = map_image_context_get_shore(grid_offset);
-        int image_id = image_group(GROUP_TERRAIN_WATER) + img->group_offset + img->item_offset;
-        if (map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING)) {
-            // fortified shore
-            int base = image_group(GROUP_TERRAIN_WATER_SHORE);
-            switch (img->group_offset) {
-                case 8: image_id = base + 10; break;
-                case 12: image_id = base + 11; break;
-                case 16: image_id = base + 9; break;
-                case 20: image_id = base + 8; break;
-                case 24: image_id = base + 18; break;
-                case 28: image_id = base + 16; break;
-                case 32: image_id = base + 19; break;
-                case 36: image_id = base + 17; break;
-                case 50: image_id = base + 12; break;
-                case 51: image_id = base + 14; break;
-                case 52: image_id = base + 13; break;
-                case 53: image_id = base + 15; break;
-            }
-        }
-        map_image_set(grid_offset, image_id);
+        int is_fortified = map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING);
+        map_image_set(grid_offset, get_water_image_id(img, is_fortified));
         map_property_set_multi_tile_size(grid_offset, 1);
         map_property_mark_draw_tile(grid_offset);
     }
@@ -893,14 +907,44 @@ static void set_water_image(int x, int y, int grid_offset)
 
 static void update_water_tile(int x, int y, int grid_offset)
 {
-    if (map_terrain_is(grid_offset, TERRAIN_WATER) && !map_terrain_is(grid_offset, TERRAIN_BUILDING)) {
+    if (is_water_tile(grid_offset)) {
         foreach_region_tile(x - 1, y - 1, x + 1, y + 1, set_water_image);
     }
 }
 
+static void prepare_water_tile(int x, int y, int grid_offset)
+{
+    if (is_water_tile(grid_offset)) {
+        water_tiles.shore_context[grid_offset] = map_image_context_find_shore(grid_offset);
+        water_tiles.is_fortified[grid_offset] =
+            map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING);
+    }
+}
+
+static void set_prepared_water_image(int x, int y, int grid_offset)
+{
+    if (is_water_tile(grid_offset)) {
+        const terrain_image *img = map_image_context_get_shore_for_context(water_tiles.shore_context[grid_offset]);
+        map_image_set(grid_offset, get_water_image_id(img, water_tiles.is_fortified[grid_offset]));
+        map_property_set_multi_tile_size(grid_offset, 1);
+        map_property_mark_draw_tile(grid_offset);
+    }
+}
+
+static void update_prepared_water_tile(int x, int y, int grid_offset)
+{
+    if (is_water_tile(grid_offset)) {
+        foreach_region_tile(x - 1, y - 1, x + 1, y + 1, set_prepared_water_image);
+    }
+}
+
 void map_tiles_update_all_water(void)
 {
-    foreach_map_tile(update_water_tile);
+    // Every water tile is updated once for each water tile around it, and its image variant changes each time.
+    // Terrain doesn't change during the update, so the shore lookups are done only once per tile
+    // while the updates themselves still happen in the original order.
+    foreach_map_tile(prepare_water_tile);
+    foreach_map_tile(update_prepared_water_tile);
 }
 
 void map_tiles_update_region_water(int x_min, int y_min, int x_max, int y_max)
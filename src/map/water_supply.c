@@ -47,7 +47,7 @@ static void mark_well_access(int well_id, int radius)
 void map_water_supply_update_houses(void)
 {
     building_list_small_clear();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
@@ -150,10 +150,9 @@ void map_water_supply_update_reservoir_fountain(void)
     set_all_aqueducts_to_no_water();
     building_list_large_clear(1);
     // mark reservoirs next to water
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_RESERVOIR) {
-            building_list_large_add(i);
+    for (building *b = building_first_of_type(BUILDING_RESERVOIR); b; b = building_next_of_type(b)) {
+        if (b->state == BUILDING_STATE_IN_USE) {
+            building_list_large_add(b->id);
             if (map_terrain_exists_tile_in_area_with_type(b->x - 1, b->y - 1, 5, TERRAIN_WATER)) {
                 b->has_water_access = 2;
             } else {
@@ -187,9 +186,8 @@ void map_water_supply_update_reservoir_fountain(void)
         }
     }
     // fountains
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_FOUNTAIN) {
+    for (building *b = building_first_of_type(BUILDING_FOUNTAIN); b; b = building_next_of_type(b)) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         int des = map_desirability_get(b->grid_offset);
@@ -203,7 +201,7 @@ void map_water_supply_update_reservoir_fountain(void)
         } else {
             image_id = image_group(GROUP_BUILDING_FOUNTAIN_1);
         }
-        map_building_tiles_add(i, b->x, b->y, 1, image_id, TERRAIN_BUILDING);
+        map_building_tiles_add(b->id, b->x, b->y, 1, image_id, TERRAIN_BUILDING);
         if (map_terrain_is(b->grid_offset, TERRAIN_RESERVOIR_RANGE) && b->num_workers) {
             b->has_water_access = 1;
             map_terrain_add_with_radius(b->x, b->y, 1,
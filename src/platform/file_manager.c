@@ -9,6 +9,7 @@
 #include "platform/vita/vita.h"
 
 #include <dirent.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -91,6 +92,22 @@ typedef const char *dir_name;
 #include <unistd.h>
 #endif
 
+#if !defined(_WIN32) && !defined(__ANDROID__) && !defined(__EMSCRIPTEN__) && \
+    !defined(__vita__) && !defined(__SWITCH__)
+#define USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__vita__)
+#define USE_FSYNC
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
 #ifdef __EMSCRIPTEN__
 static int writing_to_file;
 #endif
@@ -322,3 +339,163 @@ int platform_file_manager_close_file(FILE *stream)
 #endif
     return result;
 }
+
+int platform_file_manager_can_write_in_background(void)
+{
+#ifdef USE_FILE_CACHE
+    // the file cache is not locked, so it may only be changed from the main thread
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+int platform_file_manager_can_replace_file(void)
+{
+#ifdef __ANDROID__
+    // files are accessed through the storage access framework, which cannot rename
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+#if defined(_WIN32)
+
+void platform_file_manager_sync_file(FILE *stream)
+{
+    fflush(stream);
+    _commit(_fileno(stream));
+}
+
+int platform_file_manager_replace_file(const char *source, const char *target)
+{
+    wchar_t *wsource = utf8_to_wchar(source);
+    wchar_t *wtarget = utf8_to_wchar(target);
+    int result = MoveFileExW(wsource, wtarget, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    free(wsource);
+    free(wtarget);
+    return result != 0;
+}
+
+#elif defined(__ANDROID__)
+
+void platform_file_manager_sync_file(FILE *stream)
+{
+    fflush(stream);
+}
+
+int platform_file_manager_replace_file(const char *source, const char *target)
+{
+    return 0;
+}
+
+#else
+
+void platform_file_manager_sync_file(FILE *stream)
+{
+    fflush(stream);
+#ifdef USE_FSYNC
+    fsync(fileno(stream));
+#endif
+}
+
+int platform_file_manager_replace_file(const char *source, const char *target)
+{
+#ifdef USE_FILE_CACHE
+    int target_exists = file_exists(target, NOT_LOCALIZED);
+#endif
+    if (rename(source, target) != 0) {
+        return 0;
+    }
+#ifdef USE_FILE_CACHE
+    platform_file_manager_cache_delete_file_info(source);
+    if (!target_exists) {
+        platform_file_manager_cache_add_file_info(target);
+    }
+#endif
+#ifdef __EMSCRIPTEN__
+    EM_ASM(
+        Module.syncFS();
+    );
+#endif
+    return 1;
+}
+
+#endif
+
+#if defined(_WIN32)
+
+const void *platform_file_manager_map_file(const char *filename, int *size)
+{
+    wchar_t *wfile = utf8_to_wchar(filename);
+    HANDLE file = CreateFileW(wfile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    free(wfile);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 || file_size.QuadPart > INT_MAX) {
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return NULL;
+    }
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    // the view keeps the mapping alive
+    CloseHandle(mapping);
+    if (data) {
+        *size = (int) file_size.QuadPart;
+    }
+    return data;
+}
+
+void platform_file_manager_unmap_file(const void *data, int size)
+{
+    UnmapViewOfFile(data);
+}
+
+#elif defined(USE_MMAP)
+
+const void *platform_file_manager_map_file(const char *filename, int *size)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 || !S_ISREG(file_info.st_mode) ||
+        file_info.st_size <= 0 || file_info.st_size > INT_MAX) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) file_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing the file
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (int) file_info.st_size;
+    return data;
+}
+
+void platform_file_manager_unmap_file(const void *data, int size)
+{
+    munmap((void *) data, (size_t) size);
+}
+
+#else
+
+const void *platform_file_manager_map_file(const char *filename, int *size)
+{
+    return NULL;
+}
+
+void platform_file_manager_unmap_file(const void *data, int size)
+{
+}
+
+#endif
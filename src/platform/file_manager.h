@@ -81,4 +81,46 @@ int platform_file_manager_close_file(FILE *stream);
  */
 int platform_file_manager_remove_file(const char *filename);
 
+/**
+ * Writes everything written to the stream to the disk
+ * @param stream The stream to sync
+ */
+void platform_file_manager_sync_file(FILE *stream);
+
+/**
+ * Indicates whether files can be written from a background thread
+ * @return Whether files may be opened, renamed and removed while the main thread uses the file system
+ */
+int platform_file_manager_can_write_in_background(void);
+
+/**
+ * Indicates whether files can be renamed, replacing the target file
+ * @return Whether platform_file_manager_replace_file is supported
+ */
+int platform_file_manager_can_replace_file(void);
+
+/**
+ * Renames a file, replacing the target file in a single step
+ * @param source The file to rename
+ * @param target The new name of the file, which is replaced if it exists
+ * @return true if the file was renamed, false if renaming failed or is not supported
+ */
+int platform_file_manager_replace_file(const char *source, const char *target);
+
+/**
+ * Maps a file into memory for reading, without copying it
+ * @param filename The file to map
+ * @param size Set to the size of the file
+ * @return A pointer to the contents of the file, or NULL if the file cannot be mapped
+ *         or mapping is not supported on this platform
+ */
+const void *platform_file_manager_map_file(const char *filename, int *size);
+
+/**
+ * Unmaps a file mapped by platform_file_manager_map_file
+ * @param data Contents of the file
+ * @param size Size of the file
+ */
+void platform_file_manager_unmap_file(const void *data, int size);
+
 #endif // PLATFORM_FILE_MANAGER_H
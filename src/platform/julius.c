@@ -5,6 +5,7 @@
 #include "core/encoding.h"
 #include "core/file.h"
 #include "core/lang.h"
+#include "core/profiler.h"
 #include "core/time.h"
 #include "game/game.h"
 #include "game/settings.h"
@@ -21,6 +22,7 @@
 #include "platform/prefs.h"
 #include "platform/screen.h"
 #include "platform/touch.h"
+#include "platform/worker_pool.h"
 
 #include "tinyfiledialogs/tinyfiledialogs.h"
 
@@ -42,7 +44,7 @@
 #define SHOW_FOLDER_SELECT_DIALOG
 #endif
 
-#ifdef DRAW_FPS
+#if defined(DRAW_FPS) || defined(PROFILER)
 #include "graphics/window.h"
 #include "graphics/graphics.h"
 #include "graphics/text.h"
@@ -134,6 +136,11 @@ void system_exit(void)
     post_event(USER_EVENT_QUIT);
 }
 
+time_millis system_get_ticks(void)
+{
+    return SDL_GetTicks();
+}
+
 void system_resize(int width, int height)
 {
     static int s_width;
@@ -167,6 +174,44 @@ static void platform_per_frame_callback(void)
 }
 #endif
 
+#ifdef PROFILER
+#define PROFILER_OVERLAY_LINES 12
+
+static uint64_t profiler_clock_ticks(void)
+{
+    return SDL_GetPerformanceCounter();
+}
+
+static void init_profiler(void)
+{
+    profiler_init(profiler_clock_ticks, SDL_GetPerformanceFrequency());
+    if (!profiler_start_csv("profiler.csv")) {
+        SDL_Log("Unable to write profiler.csv");
+    }
+}
+
+static void draw_profiler(void)
+{
+    if (!window_is(WINDOW_CITY) && !window_is(WINDOW_CITY_MILITARY) && !window_is(WINDOW_SLIDING_SIDEBAR)) {
+        return;
+    }
+    profiler_section_stats stats[PROFILER_OVERLAY_LINES];
+    int num_sections = profiler_get_top_sections(stats, PROFILER_OVERLAY_LINES);
+    int y_offset = 48;
+    graphics_fill_rect(0, y_offset, 420, 16 * num_sections + 8, COLOR_WHITE);
+    for (int i = 0; i < num_sections; i++) {
+        char line[100];
+        if (stats[i].index == PROFILER_NO_INDEX) {
+            snprintf(line, sizeof(line), "%.2f / %.2f ms %s", stats[i].average_ms, stats[i].max_ms, stats[i].name);
+        } else {
+            snprintf(line, sizeof(line), "%.2f / %.2f ms %s %d",
+                stats[i].average_ms, stats[i].max_ms, stats[i].name, stats[i].index);
+        }
+        text_draw((const uint8_t *) line, 5, y_offset + 5 + 16 * i, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+    }
+}
+#endif
+
 #ifdef DRAW_FPS
 static struct {
     int frame_count;
@@ -179,9 +224,9 @@ static void run_and_draw(void)
     time_millis time_before_run = SDL_GetTicks();
     time_set_millis(time_before_run);
 
-    game_run();
+    PROFILE(game_run());
     Uint32 time_between_run_and_draw = SDL_GetTicks();
-    game_draw();
+    PROFILE(game_draw());
     Uint32 time_after_draw = SDL_GetTicks();
 
     fps.frame_count++;
@@ -201,6 +246,10 @@ static void run_and_draw(void)
         text_draw_number_colored(time_after_draw - time_between_run_and_draw,
             'd', "", 70, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
     }
+#ifdef PROFILER
+    draw_profiler();
+    profiler_finish_sample();
+#endif
     platform_screen_update();
     platform_screen_render();
 }
@@ -209,8 +258,12 @@ static void run_and_draw(void)
 {
     time_set_millis(SDL_GetTicks());
 
-    game_run();
-    game_draw();
+    PROFILE(game_run());
+    PROFILE(game_draw());
+#ifdef PROFILER
+    draw_profiler();
+    profiler_finish_sample();
+#endif
 
     platform_screen_update();
     platform_screen_render();
@@ -338,6 +391,13 @@ static void handle_event(SDL_Event *event)
             platform_joystick_device_changed(event->jdevice.which, 0);
             break;
 
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+        case SDL_RENDER_TARGETS_RESET:
+        case SDL_RENDER_DEVICE_RESET:
+            platform_screen_request_full_update();
+            break;
+#endif
+
         case SDL_QUIT:
             data.quit = 1;
             break;
@@ -364,7 +424,11 @@ static void handle_event(SDL_Event *event)
 static void teardown(void)
 {
     SDL_Log("Exiting game");
+#ifdef PROFILER
+    profiler_stop_csv();
+#endif
     game_exit();
+    platform_worker_pool_shutdown();
     platform_screen_destroy();
     SDL_Quit();
     teardown_logging();
@@ -629,6 +693,9 @@ static void setup(const julius_args *args)
         SDL_Log("Exiting: game init failed");
         exit_with_status(2);
     }
+#ifdef PROFILER
+    init_profiler();
+#endif
 
     data.quit = 0;
     data.active = 1;
@@ -21,6 +21,7 @@ static struct {
     SDL_Renderer *renderer;
     SDL_Texture *texture;
     SDL_Texture *cursors[CURSOR_MAX];
+    int texture_needs_full_update;
 } SDL;
 
 static struct {
@@ -217,6 +218,7 @@ int platform_screen_resize(int pixel_width, int pixel_height)
 
     if (SDL.texture) {
         SDL_Log("Texture created: %d x %d", logical_width, logical_height);
+        SDL.texture_needs_full_update = 1;
         screen_set_resolution(logical_width, logical_height);
         return 1;
     } else {
@@ -383,21 +385,48 @@ void platform_screen_recreate_texture(void)
         SDL.texture = SDL_CreateTexture(SDL.renderer,
             SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
             screen_width(), screen_height());
+        SDL.texture_needs_full_update = 1;
     }
 }
 #endif
 
+void platform_screen_request_full_update(void)
+{
+    SDL.texture_needs_full_update = 1;
+}
+
 void platform_screen_clear(void)
 {
     SDL_RenderClear(SDL.renderer);
 }
 
+#ifndef __vita__
+static void update_texture(void)
+{
+    const color_t *canvas = graphics_canvas();
+    int pitch = screen_width() * 4;
+    if (SDL.texture_needs_full_update) {
+        SDL_UpdateTexture(SDL.texture, NULL, canvas, pitch);
+        SDL.texture_needs_full_update = 0;
+        return;
+    }
+    // Only upload what was drawn: when paused or in a static window this is very little
+    int num_rects;
+    const graphics_rect *rects = graphics_get_dirty_rects(&num_rects);
+    for (int i = 0; i < num_rects; i++) {
+        SDL_Rect rect = { rects[i].x, rects[i].y, rects[i].width, rects[i].height };
+        SDL_UpdateTexture(SDL.texture, &rect, &canvas[rect.y * screen_width() + rect.x], pitch);
+    }
+}
+#endif
+
 void platform_screen_update(void)
 {
     SDL_RenderClear(SDL.renderer);
 #ifndef __vita__
-    SDL_UpdateTexture(SDL.texture, NULL, graphics_canvas(), screen_width() * 4);
+    update_texture();
 #endif
+    graphics_clear_dirty_rects();
     SDL_RenderCopy(SDL.renderer, SDL.texture, NULL, NULL);
 #ifdef PLATFORM_USE_SOFTWARE_CURSOR
     draw_software_mouse_cursor();
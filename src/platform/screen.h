@@ -21,6 +21,7 @@ void platform_screen_center_window(void);
 void platform_screen_recreate_texture(void);
 #endif
 
+void platform_screen_request_full_update(void);
 void platform_screen_clear(void);
 void platform_screen_update(void);
 void platform_screen_render(void);
@@ -0,0 +1,172 @@
+#include "worker_pool.h"
+
+#include "game/system.h"
+
+#include "SDL.h"
+
+#define MAX_THREADS 16
+
+static struct {
+    int initialized;
+    int num_threads;
+    SDL_Thread *threads[MAX_THREADS];
+    SDL_mutex *mutex;
+    SDL_cond *tasks_available;
+    SDL_cond *tasks_finished;
+    system_task task;
+    void *userdata;
+    int num_tasks;
+    int next_task;
+    int tasks_running;
+    int quit;
+} data;
+
+static struct {
+    SDL_Thread *thread;
+    system_task task;
+    void *userdata;
+} background;
+
+// Must be called with the mutex locked
+static void run_available_tasks(void)
+{
+    while (data.next_task < data.num_tasks) {
+        int task_id = data.next_task++;
+        data.tasks_running++;
+        SDL_UnlockMutex(data.mutex);
+        data.task(task_id, data.userdata);
+        SDL_LockMutex(data.mutex);
+        data.tasks_running--;
+    }
+    if (!data.tasks_running) {
+        SDL_CondBroadcast(data.tasks_finished);
+    }
+}
+
+static int worker(void *unused)
+{
+    SDL_LockMutex(data.mutex);
+    while (!data.quit) {
+        if (data.next_task < data.num_tasks) {
+            run_available_tasks();
+        } else {
+            SDL_CondWait(data.tasks_available, data.mutex);
+        }
+    }
+    SDL_UnlockMutex(data.mutex);
+    return 0;
+}
+
+static void init(void)
+{
+    if (data.initialized) {
+        return;
+    }
+    data.initialized = 1;
+    data.num_threads = 1;
+    int cpus = SDL_GetCPUCount();
+    if (cpus > MAX_THREADS) {
+        cpus = MAX_THREADS;
+    }
+    if (cpus <= 1) {
+        return;
+    }
+    data.mutex = SDL_CreateMutex();
+    data.tasks_available = SDL_CreateCond();
+    data.tasks_finished = SDL_CreateCond();
+    if (!data.mutex || !data.tasks_available || !data.tasks_finished) {
+        SDL_Log("Unable to create worker threads, running tasks on the main thread: %s", SDL_GetError());
+        return;
+    }
+    // the calling thread also runs tasks, so it counts as one of the threads
+    for (int i = 1; i < cpus; i++) {
+        SDL_Thread *thread = SDL_CreateThread(worker, "worker", 0);
+        if (!thread) {
+            SDL_Log("Unable to create worker thread: %s", SDL_GetError());
+            break;
+        }
+        data.threads[data.num_threads++] = thread;
+    }
+    SDL_Log("Running tasks on %d threads", data.num_threads);
+}
+
+int system_task_thread_count(void)
+{
+    init();
+    return data.num_threads;
+}
+
+void system_run_tasks(system_task task, int num_tasks, void *userdata)
+{
+    init();
+    if (data.num_threads <= 1) {
+        for (int i = 0; i < num_tasks; i++) {
+            task(i, userdata);
+        }
+        return;
+    }
+    SDL_LockMutex(data.mutex);
+    data.task = task;
+    data.userdata = userdata;
+    data.num_tasks = num_tasks;
+    data.next_task = 0;
+    SDL_CondBroadcast(data.tasks_available);
+    run_available_tasks();
+    while (data.tasks_running) {
+        SDL_CondWait(data.tasks_finished, data.mutex);
+    }
+    data.num_tasks = 0;
+    data.next_task = 0;
+    SDL_UnlockMutex(data.mutex);
+}
+
+static int run_background_task(void *unused)
+{
+    background.task(0, background.userdata);
+    return 0;
+}
+
+int system_start_background_task(system_task task, void *userdata)
+{
+    system_wait_for_background_task();
+    background.task = task;
+    background.userdata = userdata;
+    background.thread = SDL_CreateThread(run_background_task, "background", 0);
+    if (!background.thread) {
+        SDL_Log("Unable to create background thread: %s", SDL_GetError());
+        return 0;
+    }
+    return 1;
+}
+
+void system_wait_for_background_task(void)
+{
+    if (background.thread) {
+        SDL_WaitThread(background.thread, 0);
+        background.thread = 0;
+    }
+}
+
+void platform_worker_pool_shutdown(void)
+{
+    system_wait_for_background_task();
+    if (data.num_threads > 1) {
+        SDL_LockMutex(data.mutex);
+        data.quit = 1;
+        SDL_CondBroadcast(data.tasks_available);
+        SDL_UnlockMutex(data.mutex);
+        for (int i = 1; i < data.num_threads; i++) {
+            SDL_WaitThread(data.threads[i], 0);
+        }
+    }
+    if (data.mutex) {
+        SDL_DestroyMutex(data.mutex);
+    }
+    if (data.tasks_available) {
+        SDL_DestroyCond(data.tasks_available);
+    }
+    if (data.tasks_finished) {
+        SDL_DestroyCond(data.tasks_finished);
+    }
+    SDL_zero(data);
+}
@@ -0,0 +1,6 @@
+#ifndef PLATFORM_WORKER_POOL_H
+#define PLATFORM_WORKER_POOL_H
+
+void platform_worker_pool_shutdown(void);
+
+#endif // PLATFORM_WORKER_POOL_H
@@ -40,6 +40,7 @@ typedef enum {
     TR_CONFIG_SHOW_MILITARY_SIDEBAR,
     TR_CONFIG_FIX_IMMIGRATION_BUG,
     TR_CONFIG_FIX_100_YEAR_GHOSTS,
+    TR_CONFIG_EXTEND_ENTITY_LIMITS,
     TR_HOTKEY_TITLE,
     TR_HOTKEY_LABEL,
     TR_HOTKEY_ALTERNATIVE_LABEL,
@@ -6,11 +6,13 @@
 #include "city/view.h"
 #include "city/warning.h"
 #include "core/direction.h"
+#include "core/profiler.h"
 #include "core/string.h"
 #include "figure/formation_legion.h"
 #include "game/settings.h"
 #include "game/state.h"
 #include "graphics/button.h"
+#include "graphics/draw_list.h"
 #include "graphics/graphics.h"
 #include "graphics/image.h"
 #include "graphics/panel.h"
@@ -48,11 +50,15 @@ void widget_city_draw(void)
 {
     set_city_clip_rectangle();
 
+    draw_list_begin();
     if (game_state_overlay()) {
         city_with_overlay_draw(&data.current_tile);
     } else {
         city_without_overlay_draw(0, 0, &data.current_tile);
     }
+    PROFILER_START("draw city bands");
+    draw_list_end();
+    PROFILER_END();
 
     graphics_reset_clip_rectangle();
 }
@@ -61,7 +67,11 @@ void widget_city_draw_for_figure(int figure_id, pixel_coordinate *coord)
 {
     set_city_clip_rectangle();
 
+    draw_list_begin();
     city_without_overlay_draw(figure_id, coord, &data.current_tile);
+    PROFILER_START("draw city bands");
+    draw_list_end();
+    PROFILER_END();
 
     graphics_reset_clip_rectangle();
 }
@@ -235,7 +245,7 @@ static void build_end(void)
             sound_effect_play(SOUND_EFFECT_BUILD);
         }
         building_construction_place();
-        widget_minimap_invalidate();
+        widget_minimap_update();
     }
 }
 
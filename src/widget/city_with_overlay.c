@@ -8,6 +8,7 @@
 #include "core/log.h"
 #include "game/resource.h"
 #include "game/state.h"
+#include "game/time.h"
 #include "graphics/image.h"
 #include "map/bridge.h"
 #include "map/building.h"
@@ -28,8 +29,20 @@
 #include "widget/city_overlay_risks.h"
 #include "widget/city_without_overlay.h"
 
+#define VALUE_NOT_CALCULATED -2
+#define MAX_COLUMN_HEIGHT 10
+
 static const city_overlay *overlay = 0;
 
+static struct {
+    int overlay_type;
+    int year;
+    int month;
+    int day;
+    grid_i8 column_height;
+    grid_u16 building_id;
+} values;
+
 #define OFFSET(x,y) (x + GRID_SIZE * y)
 
 static const int ADJACENT_OFFSETS[2][4][7] = {
@@ -109,9 +122,43 @@ static int select_city_overlay(void)
     return overlay != 0;
 }
 
+static void clear_values(void)
+{
+    values.overlay_type = overlay ? overlay->type : OVERLAY_NONE;
+    values.year = game_time_year();
+    values.month = game_time_month();
+    values.day = game_time_day();
+    map_grid_init_i8(values.column_height.items, VALUE_NOT_CALCULATED);
+}
+
+static void prepare_values(void)
+{
+    // values only change during the simulation, so they are calculated at most once per day;
+    // loading a game and UI actions like changing taxes call city_with_overlay_update()
+    if (values.overlay_type != overlay->type || values.day != game_time_day() ||
+        values.month != game_time_month() || values.year != game_time_year()) {
+        clear_values();
+    }
+}
+
+static int get_column_height(const building *b, int grid_offset)
+{
+    if (values.building_id.items[grid_offset] != b->id ||
+        values.column_height.items[grid_offset] == VALUE_NOT_CALCULATED) {
+        int height = overlay->get_column_height(b);
+        if (height > MAX_COLUMN_HEIGHT) {
+            height = MAX_COLUMN_HEIGHT;
+        }
+        values.building_id.items[grid_offset] = (uint16_t) b->id;
+        values.column_height.items[grid_offset] = (int8_t) height;
+    }
+    return values.column_height.items[grid_offset];
+}
+
 void city_with_overlay_update(void)
 {
     select_city_overlay();
+    clear_values();
 }
 
 static int is_drawable_farmhouse(int grid_offset, int map_orientation)
@@ -319,8 +366,8 @@ static void draw_overlay_column(int x, int y, int height, int is_red)
     if (is_red) {
         image_id += 9;
     }
-    if (height > 10) {
-        height = 10;
+    if (height > MAX_COLUMN_HEIGHT) {
+        height = MAX_COLUMN_HEIGHT;
     }
     int capital_height = image_get(image_id)->height;
     // base
@@ -379,7 +426,7 @@ void city_with_overlay_draw_building_top(int x, int y, int grid_offset)
     if (overlay->show_building(b)) {
         draw_building_top(grid_offset, b, x, y);
     } else {
-        int column_height = overlay->get_column_height(b);
+        int column_height = get_column_height(b, grid_offset);
         if (column_height != NO_COLUMN) {
             int draw = 1;
             if (building_is_farm(b->type)) {
@@ -543,6 +590,7 @@ void city_with_overlay_draw(const map_tile *tile)
     if (!select_city_overlay()) {
         return;
     }
+    prepare_values();
 
     int should_mark_deleting = city_building_ghost_mark_deleting(tile);
     city_view_foreach_map_tile(draw_footprint);
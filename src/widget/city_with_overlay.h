@@ -5,7 +5,8 @@
 #include "map/point.h"
 
 /**
- * Update the internal state after changing overlay
+ * Update the internal state after changing overlay, loading a game
+ * or changing anything outside the simulation that the overlay shows
  */
 void city_with_overlay_update(void);
 
@@ -10,9 +10,12 @@
 #include "city/ratings.h"
 #include "city/view.h"
 #include "core/config.h"
+#include "core/image.h"
+#include "core/profiler.h"
 #include "core/time.h"
 #include "figure/formation_legion.h"
 #include "game/resource.h"
+#include "graphics/graphics.h"
 #include "graphics/image.h"
 #include "graphics/window.h"
 #include "map/building.h"
@@ -27,8 +30,14 @@
 #include "widget/city_building_ghost.h"
 #include "widget/city_figure.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define OFFSET(x,y) (x + GRID_SIZE * y)
 
+#define FOOTPRINT_TILE_WIDTH 60
+#define FOOTPRINT_HALF_TILE_HEIGHT 15
+
 static const int ADJACENT_OFFSETS[2][4][7] = {
     {
         {OFFSET(-1, 0), OFFSET(-1, -1),  OFFSET(-1, -2), OFFSET(0, -2), OFFSET(1, -2)},
@@ -55,6 +64,28 @@ static struct {
     pixel_coordinate *selected_figure_coord;
 } draw_context;
 
+typedef struct {
+    int image_id;
+    color_t color_mask;
+    int generation;
+} footprint_record;
+
+// Footprints of the last frame: only footprints that changed are drawn again
+static struct {
+    color_t *pixels;
+    int x;
+    int y;
+    int width;
+    int height;
+    int camera_x;
+    int camera_y;
+    int camera_row_parity;
+    int orientation;
+    int climate_version;
+    int generation;
+    footprint_record records[GRID_SIZE * GRID_SIZE];
+} footprint_cache;
+
 static void init_draw_context(int selected_figure_id, pixel_coordinate *figure_coord, int highlighted_formation)
 {
     draw_context.advance_water_animation = 0;
@@ -97,51 +128,182 @@ static int has_adjacent_deletion(int grid_offset)
     return 0;
 }
 
-static void draw_footprint(int x, int y, int grid_offset)
+static int get_footprint(int x, int y, int grid_offset, int *image_id, color_t *color_mask)
 {
     building_construction_record_view_position(x, y, grid_offset);
+    *color_mask = 0;
     if (grid_offset < 0) {
         // Outside map: draw black tile
-        image_draw_isometric_footprint_from_draw_tile(image_group(GROUP_TERRAIN_BLACK), x, y, 0);
-    } else if (map_property_is_draw_tile(grid_offset)) {
-        // Valid grid_offset and leftmost tile -> draw
-        int building_id = map_building_at(grid_offset);
-        color_t color_mask = 0;
-        if (building_id) {
-            building *b = building_get(building_id);
-            if (draw_building_as_deleted(b)) {
-                color_mask = COLOR_MASK_RED;
-            }
-            int view_x, view_y, view_width, view_height;
-            city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
-            if (x < view_x + 100) {
-                sound_city_mark_building_view(b, SOUND_DIRECTION_LEFT);
-            } else if (x > view_x + view_width - 100) {
-                sound_city_mark_building_view(b, SOUND_DIRECTION_RIGHT);
-            } else {
-                sound_city_mark_building_view(b, SOUND_DIRECTION_CENTER);
-            }
+        *image_id = image_group(GROUP_TERRAIN_BLACK);
+        return 1;
+    }
+    if (!map_property_is_draw_tile(grid_offset)) {
+        return 0;
+    }
+    // Valid grid_offset and leftmost tile -> draw
+    int building_id = map_building_at(grid_offset);
+    if (building_id) {
+        building *b = building_get(building_id);
+        if (draw_building_as_deleted(b)) {
+            *color_mask = COLOR_MASK_RED;
         }
-        if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
-            building *b = building_get(0); // abuse empty building
-            b->type = BUILDING_GARDENS;
+        int view_x, view_y, view_width, view_height;
+        city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
+        if (x < view_x + 100) {
+            sound_city_mark_building_view(b, SOUND_DIRECTION_LEFT);
+        } else if (x > view_x + view_width - 100) {
+            sound_city_mark_building_view(b, SOUND_DIRECTION_RIGHT);
+        } else {
             sound_city_mark_building_view(b, SOUND_DIRECTION_CENTER);
         }
-        int image_id = map_image_at(grid_offset);
-        if (map_property_is_constructing(grid_offset)) {
-            image_id = image_group(GROUP_TERRAIN_OVERLAY);
-        }
-        if (draw_context.advance_water_animation &&
-            image_id >= draw_context.image_id_water_first &&
-            image_id <= draw_context.image_id_water_last) {
-            image_id++;
-            if (image_id > draw_context.image_id_water_last) {
-                image_id = draw_context.image_id_water_first;
-            }
-            map_image_set(grid_offset, image_id);
+    }
+    if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
+        building *b = building_get(0); // abuse empty building
+        b->type = BUILDING_GARDENS;
+        sound_city_mark_building_view(b, SOUND_DIRECTION_CENTER);
+    }
+    *image_id = map_image_at(grid_offset);
+    if (map_property_is_constructing(grid_offset)) {
+        *image_id = image_group(GROUP_TERRAIN_OVERLAY);
+    }
+    if (draw_context.advance_water_animation &&
+        *image_id >= draw_context.image_id_water_first &&
+        *image_id <= draw_context.image_id_water_last) {
+        (*image_id)++;
+        if (*image_id > draw_context.image_id_water_last) {
+            *image_id = draw_context.image_id_water_first;
         }
+        map_image_set(grid_offset, *image_id);
+    }
+    return 1;
+}
+
+static void draw_footprint(int x, int y, int grid_offset)
+{
+    int image_id;
+    color_t color_mask;
+    if (get_footprint(x, y, grid_offset, &image_id, &color_mask)) {
+        image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask);
+    }
+}
+
+static int footprint_fits_in_cache(int image_id, int x, int y)
+{
+    const image *img = image_get(image_id);
+    if (img->draw.type != IMAGE_TYPE_ISOMETRIC) {
+        return 1;
+    }
+    int size = (img->width + 2) / FOOTPRINT_TILE_WIDTH;
+    int y_top = y - (size - 1) * FOOTPRINT_HALF_TILE_HEIGHT;
+    return x >= footprint_cache.x && x + img->width <= footprint_cache.x + footprint_cache.width &&
+        y_top >= footprint_cache.y && y_top + size * 2 * FOOTPRINT_HALF_TILE_HEIGHT <=
+        footprint_cache.y + footprint_cache.height;
+}
+
+static void draw_cached_footprint(int x, int y, int grid_offset)
+{
+    int image_id;
+    color_t color_mask;
+    if (!get_footprint(x, y, grid_offset, &image_id, &color_mask)) {
+        return;
+    }
+    if (grid_offset < 0) {
         image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask);
+        return;
+    }
+    footprint_record *record = &footprint_cache.records[grid_offset];
+    int fits = footprint_fits_in_cache(image_id, x, y);
+    if (fits && record->generation == footprint_cache.generation - 1 &&
+        record->image_id == image_id && record->color_mask == color_mask) {
+        // the cache still holds this footprint
+        record->generation = footprint_cache.generation;
+        return;
+    }
+    image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask);
+    record->image_id = image_id;
+    record->color_mask = color_mask;
+    // a footprint that is only partly in the cache has to be drawn again when the view moves
+    record->generation = fits ? footprint_cache.generation : 0;
+}
+
+static void shift_footprint_cache(int dx, int dy)
+{
+    // the pixel at (x + dx, y + dy) moves to (x, y)
+    int width = footprint_cache.width - abs(dx);
+    int height = footprint_cache.height - abs(dy);
+    int src_x = dx > 0 ? dx : 0;
+    int dst_x = dx > 0 ? 0 : -dx;
+    color_t *pixels = footprint_cache.pixels;
+    if (dy >= 0) {
+        for (int y = 0; y < height; y++) {
+            memmove(&pixels[y * footprint_cache.width + dst_x],
+                &pixels[(y + dy) * footprint_cache.width + src_x], width * sizeof(color_t));
+        }
+    } else {
+        for (int y = height - 1; y >= 0; y--) {
+            memmove(&pixels[(y - dy) * footprint_cache.width + dst_x],
+                &pixels[y * footprint_cache.width + src_x], width * sizeof(color_t));
+        }
+    }
+}
+
+static int prepare_footprint_cache(void)
+{
+    int x, y, width, height;
+    city_view_get_viewport(&x, &y, &width, &height);
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+    if (width != footprint_cache.width || height != footprint_cache.height) {
+        free(footprint_cache.pixels);
+        footprint_cache.pixels = (color_t *) malloc((size_t) width * height * sizeof(color_t));
+        if (!footprint_cache.pixels) {
+            footprint_cache.width = 0;
+            footprint_cache.height = 0;
+            return 0;
+        }
+        footprint_cache.width = width;
+        footprint_cache.height = height;
+        footprint_cache.generation += 2;
+    }
+    int camera_x, camera_y, camera_tile_x, camera_tile_y;
+    city_view_get_camera_in_pixels(&camera_x, &camera_y);
+    city_view_get_camera(&camera_tile_x, &camera_tile_y);
+    int dx = camera_x - footprint_cache.camera_x;
+    int dy = camera_y - footprint_cache.camera_y;
+    if (x != footprint_cache.x || y != footprint_cache.y ||
+        city_view_orientation() != footprint_cache.orientation ||
+        image_climate_version() != footprint_cache.climate_version ||
+        // odd and even rows of tiles are offset differently
+        (camera_tile_y & 1) != footprint_cache.camera_row_parity ||
+        abs(dx) >= width || abs(dy) >= height) {
+        footprint_cache.generation += 2;
+    } else if (dx || dy) {
+        shift_footprint_cache(dx, dy);
+    }
+    footprint_cache.x = x;
+    footprint_cache.y = y;
+    footprint_cache.camera_x = camera_x;
+    footprint_cache.camera_y = camera_y;
+    footprint_cache.camera_row_parity = camera_tile_y & 1;
+    footprint_cache.orientation = city_view_orientation();
+    footprint_cache.climate_version = image_climate_version();
+    footprint_cache.generation++;
+    return 1;
+}
+
+static void draw_footprints(void)
+{
+    if (!prepare_footprint_cache()) {
+        city_view_foreach_map_tile(draw_footprint);
+        return;
     }
+    graphics_set_custom_canvas(footprint_cache.pixels,
+        footprint_cache.x, footprint_cache.y, footprint_cache.width, footprint_cache.height);
+    city_view_foreach_map_tile(draw_cached_footprint);
+    graphics_restore_canvas();
+    graphics_draw_from_buffer(footprint_cache.x, footprint_cache.y,
+        footprint_cache.width, footprint_cache.height, footprint_cache.pixels);
 }
 
 static void draw_hippodrome_spectators(const building *b, int x, int y, color_t color_mask)
@@ -519,24 +681,34 @@ void city_without_overlay_draw(int selected_figure_id, pixel_coordinate *figure_
     }
     init_draw_context(selected_figure_id, figure_coord, highlighted_formation);
     int should_mark_deleting = city_building_ghost_mark_deleting(tile);
-    city_view_foreach_map_tile(draw_footprint);
+    PROFILER_START("draw footprints");
+    draw_footprints();
+    PROFILER_END();
     if (!should_mark_deleting) {
+        PROFILER_START("draw tops, figures and animations");
         city_view_foreach_valid_map_tile_row(
             draw_top,
             draw_figures,
             draw_animation
         );
+        PROFILER_END();
         if (!selected_figure_id) {
+            PROFILER_START("draw building ghost");
             city_building_ghost_draw(tile);
+            PROFILER_END();
         }
+        PROFILER_START("draw elevated figures and ornaments");
         city_view_foreach_valid_map_tile_row(
             draw_elevated_figures,
             draw_hippodrome_ornaments,
             0
         );
+        PROFILER_END();
     } else {
+        PROFILER_START("draw deletion");
         city_view_foreach_valid_map_tile(deletion_draw_terrain_top);
         city_view_foreach_valid_map_tile(deletion_draw_figures_animations);
         city_view_foreach_valid_map_tile(deletion_draw_remaining);
+        PROFILER_END();
     }
 }
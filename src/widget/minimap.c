@@ -15,6 +15,11 @@
 #include "scenario/property.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+// how many rows a minimap tile can draw above or below its own row
+#define TILE_ROW_MARGIN 6
+#define MAX_REDRAW_BANDS 8
 
 enum {
     FIGURE_COLOR_NONE = 0,
@@ -27,7 +32,8 @@ enum {
 enum {
     REFRESH_NOT_NEEDED = 0,
     REFRESH_FULL = 1,
-    REFRESH_CAMERA_MOVED = 2
+    REFRESH_CAMERA_MOVED = 2,
+    REFRESH_CHANGED_TILES = 3
 };
 
 static const color_t ENEMY_COLOR_BY_CLIMATE[] = {
@@ -47,6 +53,13 @@ static struct {
     int height;
     color_t enemy_color;
     color_t *cache;
+    uint8_t *dirty_rows;
+    int cache_valid;
+    int tile_keys[GRID_SIZE * GRID_SIZE];
+    struct {
+        int first_row;
+        int last_row;
+    } redraw;
     struct {
         int x;
         int y;
@@ -59,7 +72,14 @@ static struct {
 
 void widget_minimap_invalidate(void)
 {
-    data.refresh_requested = 1;
+    data.refresh_requested = REFRESH_FULL;
+}
+
+void widget_minimap_update(void)
+{
+    if (data.refresh_requested != REFRESH_FULL) {
+        data.refresh_requested = REFRESH_CHANGED_TILES;
+    }
 }
 
 static void foreach_map_tile(map_callback *callback)
@@ -141,17 +161,15 @@ static int draw_figure(int x_view, int y_view, int grid_offset)
     return 1;
 }
 
-static void draw_minimap_tile(int x_view, int y_view, int grid_offset)
+static void draw_figure_tile(int x_view, int y_view, int grid_offset)
 {
-    if (grid_offset < 0) {
-        image_draw(image_group(GROUP_MINIMAP_BLACK), x_view, y_view);
-        return;
-    }
-
-    if (draw_figure(x_view, y_view, grid_offset)) {
-        return;
+    if (grid_offset >= 0 && map_has_figure_at(grid_offset)) {
+        draw_figure(x_view, y_view, grid_offset);
     }
+}
 
+static int get_tile_key(int grid_offset)
+{
     int terrain = map_terrain_get(grid_offset);
     // exception for fort ground: display as empty land
     if (terrain & TERRAIN_BUILDING) {
@@ -160,28 +178,27 @@ static void draw_minimap_tile(int x_view, int y_view, int grid_offset)
         }
     }
 
+    int image_id;
+    int size = 1;
     if (terrain & TERRAIN_BUILDING) {
-        if (map_property_is_draw_tile(grid_offset)) {
-            int image_id;
-            building *b = building_get(map_building_at(grid_offset));
-            if (b->house_size) {
-                image_id = image_group(GROUP_MINIMAP_HOUSE);
-            } else if (b->type == BUILDING_RESERVOIR) {
-                image_id = image_group(GROUP_MINIMAP_AQUEDUCT) - 1;
-            } else {
-                image_id = image_group(GROUP_MINIMAP_BUILDING);
-            }
-            switch (map_property_multi_tile_size(grid_offset)) {
-                case 1: image_draw(image_id, x_view, y_view); break;
-                case 2: image_draw(image_id + 1, x_view, y_view - 1); break;
-                case 3: image_draw(image_id + 2, x_view, y_view - 2); break;
-                case 4: image_draw(image_id + 3, x_view, y_view - 3); break;
-                case 5: image_draw(image_id + 4, x_view, y_view - 4); break;
-            }
+        if (!map_property_is_draw_tile(grid_offset)) {
+            return 0;
+        }
+        building *b = building_get(map_building_at(grid_offset));
+        if (b->house_size) {
+            image_id = image_group(GROUP_MINIMAP_HOUSE);
+        } else if (b->type == BUILDING_RESERVOIR) {
+            image_id = image_group(GROUP_MINIMAP_AQUEDUCT) - 1;
+        } else {
+            image_id = image_group(GROUP_MINIMAP_BUILDING);
+        }
+        size = map_property_multi_tile_size(grid_offset);
+        if (size < 1 || size > 5) {
+            return 0;
         }
+        image_id += size - 1;
     } else {
         int rand = map_random_get(grid_offset);
-        int image_id;
         if (terrain & TERRAIN_ROAD) {
             image_id = image_group(GROUP_MINIMAP_ROAD);
         } else if (terrain & TERRAIN_WATER) {
@@ -199,7 +216,22 @@ static void draw_minimap_tile(int x_view, int y_view, int grid_offset)
         } else {
             image_id = image_group(GROUP_MINIMAP_EMPTY_LAND) + (rand & 7);
         }
-        image_draw(image_id, x_view, y_view);
+    }
+    // the key holds everything needed to draw the tile
+    return image_id * 8 + size;
+}
+
+static void draw_terrain_tile(int x_view, int y_view, int grid_offset)
+{
+    if (grid_offset < 0) {
+        image_draw(image_group(GROUP_MINIMAP_BLACK), x_view, y_view);
+        return;
+    }
+    int key = get_tile_key(grid_offset);
+    data.tile_keys[grid_offset] = key;
+    if (key) {
+        int size = key % 8;
+        image_draw(key / 8, x_view, y_view - (size - 1));
     }
 }
 
@@ -230,7 +262,9 @@ static void prepare_minimap_cache(int width, int height)
 {
     if (width != data.width || height != data.height) {
         free(data.cache);
+        free(data.dirty_rows);
         data.cache = (color_t *)malloc(sizeof(color_t) * width * height);
+        data.dirty_rows = (uint8_t *) malloc(height);
     }
 }
 
@@ -242,8 +276,88 @@ static void cache_minimap(void)
 static void draw_minimap(void)
 {
     graphics_set_clip_rectangle(data.x_offset, data.y_offset, data.width, data.height);
-    foreach_map_tile(draw_minimap_tile);
+    foreach_map_tile(draw_terrain_tile);
     cache_minimap();
+    data.cache_valid = data.cache && data.dirty_rows;
+    foreach_map_tile(draw_figure_tile);
+    draw_viewport_rectangle();
+    graphics_reset_clip_rectangle();
+}
+
+static void find_changed_tile(int x_view, int y_view, int grid_offset)
+{
+    if (grid_offset < 0 || get_tile_key(grid_offset) == data.tile_keys[grid_offset]) {
+        return;
+    }
+    int row = y_view - data.y_offset;
+    int first_row = row - TILE_ROW_MARGIN;
+    int last_row = row + TILE_ROW_MARGIN;
+    if (first_row < 0) {
+        first_row = 0;
+    }
+    if (last_row >= data.height) {
+        last_row = data.height - 1;
+    }
+    if (first_row <= last_row) {
+        memset(&data.dirty_rows[first_row], 1, last_row - first_row + 1);
+    }
+}
+
+static void redraw_tile_in_band(int x_view, int y_view, int grid_offset)
+{
+    int row = y_view - data.y_offset;
+    if (row >= data.redraw.first_row - TILE_ROW_MARGIN && row <= data.redraw.last_row + TILE_ROW_MARGIN) {
+        draw_terrain_tile(x_view, y_view, grid_offset);
+    }
+}
+
+static void redraw_band(int first_row, int last_row)
+{
+    // all tiles that can reach the band are drawn again in the original order,
+    // so the pixels end up exactly the same as when drawing the whole minimap
+    data.redraw.first_row = first_row;
+    data.redraw.last_row = last_row;
+    graphics_set_clip_rectangle(data.x_offset, data.y_offset + first_row, data.width, last_row - first_row + 1);
+    foreach_map_tile(redraw_tile_in_band);
+}
+
+static void redraw_changed_tiles(void)
+{
+    memset(data.dirty_rows, 0, data.height);
+    foreach_map_tile(find_changed_tile);
+
+    int bands = 0;
+    int row = 0;
+    while (row < data.height) {
+        if (!data.dirty_rows[row]) {
+            row++;
+            continue;
+        }
+        int first_row = row;
+        int last_row = row;
+        // bands close to each other share the tiles they draw, so they are merged
+        for (row++; row < data.height; row++) {
+            if (data.dirty_rows[row]) {
+                last_row = row;
+            } else if (row - last_row > 2 * TILE_ROW_MARGIN && bands < MAX_REDRAW_BANDS - 1) {
+                break;
+            }
+        }
+        redraw_band(first_row, last_row);
+        bands++;
+    }
+    if (bands) {
+        graphics_set_clip_rectangle(data.x_offset, data.y_offset, data.width, data.height);
+        cache_minimap();
+    }
+}
+
+static void update_minimap(void)
+{
+    graphics_set_clip_rectangle(data.x_offset, data.y_offset, data.width, data.height);
+    graphics_draw_from_buffer(data.x_offset, data.y_offset, data.width, data.height, data.cache);
+    redraw_changed_tiles();
+    foreach_map_tile(draw_figure_tile);
     draw_viewport_rectangle();
     graphics_reset_clip_rectangle();
 }
@@ -256,9 +370,9 @@ static void draw_uncached(int x_offset, int y_offset, int width, int height)
     draw_minimap();
 }
 
-static void draw_using_cache(int x_offset, int y_offset, int width, int height)
+static void draw_using_cache(int x_offset, int y_offset, int width, int height, int update_tiles)
 {
-    if (width != data.width || height != data.height || x_offset != data.x_offset) {
+    if (!data.cache_valid || width != data.width || height != data.height || x_offset != data.x_offset) {
         draw_uncached(x_offset, y_offset, width, height);
         return;
     }
@@ -271,8 +385,13 @@ static void draw_using_cache(int x_offset, int y_offset, int width, int height)
         return;
     }
 
+    if (update_tiles) {
+        update_minimap();
+        return;
+    }
     graphics_set_clip_rectangle(x_offset, y_offset, width, height);
     graphics_draw_from_buffer(x_offset, y_offset, data.width, data.height, data.cache);
+    foreach_map_tile(draw_figure_tile);
     draw_viewport_rectangle();
     graphics_reset_clip_rectangle();
 }
@@ -280,8 +399,9 @@ static void draw_using_cache(int x_offset, int y_offset, int width, int height)
 static int should_refresh(int force)
 {
     if (data.refresh_requested || force) {
+        int refresh_type = data.refresh_requested == REFRESH_FULL ? REFRESH_FULL : REFRESH_CHANGED_TILES;
         data.refresh_requested = 0;
-        return REFRESH_FULL;
+        return refresh_type;
     }
     int new_x, new_y;
     city_view_get_camera(&new_x, &new_y);
@@ -298,7 +418,7 @@ void widget_minimap_draw(int x_offset, int y_offset, int width, int height, int
         if (refresh_type == REFRESH_FULL) {
             draw_uncached(x_offset, y_offset, width, height);
         } else {
-            draw_using_cache(x_offset, y_offset, width, height);
+            draw_using_cache(x_offset, y_offset, width, height, refresh_type == REFRESH_CHANGED_TILES);
         }
         graphics_draw_horizontal_line(x_offset - 1, x_offset - 1 + width, y_offset - 1, COLOR_MINIMAP_DARK);
         graphics_draw_vertical_line(x_offset - 1, y_offset, y_offset + height, COLOR_MINIMAP_DARK);
@@ -3,8 +3,16 @@
 
 #include "input/mouse.h"
 
+/**
+ * Redraws the whole minimap the next time it is drawn, for example after the layout changed
+ */
 void widget_minimap_invalidate(void);
 
+/**
+ * Redraws only the tiles that changed the next time the minimap is drawn
+ */
+void widget_minimap_update(void);
+
 void widget_minimap_draw(int x_offset, int y_offset, int width, int height, int force);
 
 int widget_minimap_handle_mouse(const mouse *m);
@@ -9,6 +9,7 @@
 #include "graphics/panel.h"
 #include "graphics/text.h"
 #include "graphics/window.h"
+#include "widget/city_with_overlay.h"
 
 #define ADVISOR_HEIGHT 26
 
@@ -113,6 +114,7 @@ static void button_change_taxes(int is_down, int param2)
     city_finance_change_tax_percentage(is_down ? -1 : 1);
     city_finance_estimate_taxes();
     city_finance_calculate_totals();
+    city_with_overlay_update();
     window_invalidate();
 }
 
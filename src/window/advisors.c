@@ -9,6 +9,7 @@
 #include "city/ratings.h"
 #include "city/resource.h"
 #include "city/warning.h"
+#include "core/image.h"
 #include "core/image_group.h"
 #include "figure/formation.h"
 #include "game/settings.h"
@@ -132,6 +133,7 @@ static void init(void)
 
     city_ratings_update_explanations();
 
+    image_prefetch_group(GROUP_ADVISOR_BACKGROUND);
     set_advisor_window();
 }
 
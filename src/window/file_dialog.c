@@ -29,6 +29,7 @@
 
 #define NUM_FILES_IN_VIEW 12
 #define MAX_FILE_WINDOW_TEXT_WIDTH (18 * BLOCK_SIZE)
+#define NUM_CACHED_PREVIEWS 32
 
 static const time_millis NOT_EXIST_MESSAGE_TIMEOUT = 500;
 
@@ -78,6 +79,19 @@ static struct {
 
 static input_box file_name_input = {144, 80, 20, 2, FONT_NORMAL_WHITE, 0, data.typed_name, FILE_NAME_MAX};
 
+typedef struct {
+    char filename[FILE_NAME_MAX];
+    int is_valid;
+    saved_game_info info;
+} saved_game_preview;
+
+// previews of saved games, so hovering over the list does not read the same files again
+static struct {
+    saved_game_preview previews[NUM_CACHED_PREVIEWS];
+    int num_previews;
+    int next_index;
+} preview_cache;
+
 static file_type_data saved_game_data = {"sav"};
 static file_type_data scenario_data = {"map"};
 
@@ -147,6 +161,55 @@ static void init(file_type type, file_dialog_type dialog_type)
 
     strncpy(data.selected_file, data.file_data->last_loaded_file, FILE_NAME_MAX);
     input_box_start(&file_name_input);
+
+    // files may have been saved since the dialog was last open
+    preview_cache.num_previews = 0;
+    preview_cache.next_index = 0;
+}
+
+static int has_preview(void)
+{
+    return data.type == FILE_TYPE_SAVED_GAME && data.dialog_type == FILE_DIALOG_LOAD;
+}
+
+static const saved_game_info *get_preview(const char *filename)
+{
+    if (!*filename) {
+        return 0;
+    }
+    for (int i = 0; i < preview_cache.num_previews; i++) {
+        saved_game_preview *preview = &preview_cache.previews[i];
+        if (strcmp(preview->filename, filename) == 0) {
+            return preview->is_valid ? &preview->info : 0;
+        }
+    }
+    saved_game_preview *preview = &preview_cache.previews[preview_cache.next_index];
+    preview_cache.next_index = (preview_cache.next_index + 1) % NUM_CACHED_PREVIEWS;
+    if (preview_cache.num_previews < NUM_CACHED_PREVIEWS) {
+        preview_cache.num_previews++;
+    }
+    strncpy(preview->filename, filename, FILE_NAME_MAX);
+    preview->filename[FILE_NAME_MAX - 1] = 0;
+    preview->is_valid = file_exists(filename, NOT_LOCALIZED) && game_file_read_saved_game_info(filename, &preview->info);
+    return preview->is_valid ? &preview->info : 0;
+}
+
+static void draw_preview(void)
+{
+    const char *filename = data.selected_file;
+    int focus_index = scrollbar.scroll_position + data.focus_button_id - 1;
+    if (data.focus_button_id && focus_index < data.file_list->num_files) {
+        filename = data.file_list->files[focus_index];
+    }
+    const saved_game_info *info = get_preview(filename);
+    if (!info) {
+        return;
+    }
+    lang_text_draw_month_year_max_width(info->month, info->year, 160, 374, 100, FONT_NORMAL_BLACK, 0);
+    int width = lang_text_draw(6, 0, 270, 374, FONT_NORMAL_BLACK);
+    text_draw_number(info->treasury, '@', " ", 266 + width, 374, FONT_NORMAL_BLACK);
+    width = lang_text_draw(6, 1, 370, 374, FONT_NORMAL_BLACK);
+    text_draw_number(info->population, '@', " ", 366 + width, 374, FONT_NORMAL_BLACK);
 }
 
 static void draw_foreground(void)
@@ -154,7 +217,7 @@ static void draw_foreground(void)
     graphics_in_dialog();
     uint8_t file[FILE_NAME_MAX];
 
-    outer_panel_draw(128, 40, 24, 21);
+    outer_panel_draw(128, 40, 24, has_preview() ? 23 : 21);
     input_box_draw(&file_name_input);
     inner_panel_draw(144, 120, 20, 13);
 
@@ -181,6 +244,10 @@ static void draw_foreground(void)
         text_draw(file, 160, 130 + 16 * i, font, 0);
     }
 
+    if (has_preview()) {
+        draw_preview();
+    }
+
     image_buttons_draw(0, 0, image_buttons, 2);
     scrollbar_draw(&scrollbar);
 
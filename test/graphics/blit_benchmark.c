@@ -0,0 +1,176 @@
+#include "graphics/blit.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_PIXELS 4096
+#define MAX_RUN 80
+#define VERIFY_ROUNDS 20000
+#define BENCHMARK_PIXELS 200000000
+
+typedef enum {
+    KERNEL_FILL,
+    KERNEL_COPY_MASKED,
+    KERNEL_MASK,
+    KERNEL_BLEND_ALPHA,
+    KERNEL_COPY_OPAQUE,
+    KERNEL_MAX
+} kernel;
+
+static const char *KERNEL_NAMES[KERNEL_MAX] = {
+    "fill", "copy masked", "mask", "blend alpha", "copy opaque"
+};
+
+static color_t src[BUFFER_PIXELS];
+static color_t expected[BUFFER_PIXELS];
+static color_t actual[BUFFER_PIXELS];
+
+static double now_ms(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static color_t random_color(void)
+{
+    return ((color_t) rand() << 16) ^ (color_t) rand();
+}
+
+static void fill_random(color_t *pixels, int num_pixels)
+{
+    for (int i = 0; i < num_pixels; i++) {
+        // plenty of transparent pixels for the opaque copy
+        pixels[i] = rand() % 4 ? random_color() : COLOR_SG2_TRANSPARENT;
+    }
+}
+
+static color_t random_alpha_color(void)
+{
+    return (random_color() & 0xffffff) | (color_t) (1 + rand() % 254) << 24;
+}
+
+static void run_kernel(const blit_functions *f, kernel k, color_t *dst, const color_t *s, color_t color, int n)
+{
+    switch (k) {
+        case KERNEL_FILL:
+            f->fill(dst, color, n);
+            break;
+        case KERNEL_COPY_MASKED:
+            f->copy_masked(dst, s, color, n);
+            break;
+        case KERNEL_MASK:
+            f->mask(dst, color, n);
+            break;
+        case KERNEL_BLEND_ALPHA:
+            f->blend_alpha(dst, color, n);
+            break;
+        default:
+            f->copy_opaque(dst, s, n);
+            break;
+    }
+}
+
+static int verify(blit_implementation implementation)
+{
+    blit_set_implementation(BLIT_IMPLEMENTATION_SCALAR);
+    const blit_functions *scalar = blit_get_functions();
+    blit_set_implementation(implementation);
+    const blit_functions *tested = blit_get_functions();
+    int errors = 0;
+    for (int k = 0; k < KERNEL_MAX; k++) {
+        for (int round = 0; round < VERIFY_ROUNDS; round++) {
+            int offset = rand() % 16;
+            int n = rand() % MAX_RUN;
+            color_t color = k == KERNEL_BLEND_ALPHA ? random_alpha_color() : random_color();
+            fill_random(src, offset + n + 16);
+            fill_random(expected, offset + n + 16);
+            memcpy(actual, expected, (offset + n + 16) * sizeof(color_t));
+            run_kernel(scalar, k, &expected[offset], &src[offset], color, n);
+            run_kernel(tested, k, &actual[offset], &src[offset], color, n);
+            if (memcmp(expected, actual, (offset + n + 16) * sizeof(color_t)) != 0) {
+                printf("%s: %s differs from scalar (length %d, color %08x)\n",
+                    blit_implementation_name(implementation), KERNEL_NAMES[k], n, color);
+                errors++;
+                break;
+            }
+        }
+    }
+    return errors;
+}
+
+static void benchmark(blit_implementation implementation, int run_length)
+{
+    blit_set_implementation(implementation);
+    const blit_functions *f = blit_get_functions();
+    printf("%-7s", blit_implementation_name(implementation));
+    for (int k = 0; k < KERNEL_MAX; k++) {
+        color_t color = k == KERNEL_BLEND_ALPHA ? 0x80336699 : 0xff0818;
+        int runs = BENCHMARK_PIXELS / run_length;
+        int offset = 0;
+        double start = now_ms();
+        for (int i = 0; i < runs; i++) {
+            run_kernel(f, k, &actual[offset], &src[offset], color, run_length);
+            offset += run_length + 3;
+            if (offset + run_length > BUFFER_PIXELS) {
+                offset = 0;
+            }
+        }
+        double elapsed = now_ms() - start;
+        printf("  %9.3f", elapsed * 1000000.0 / BENCHMARK_PIXELS);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int verify_only = argc > 1 && strcmp(argv[1], "--verify") == 0;
+    srand(1);
+    int errors = 0;
+    for (int i = 0; i < BLIT_IMPLEMENTATION_MAX; i++) {
+        if (blit_is_supported((blit_implementation) i)) {
+            errors += verify((blit_implementation) i);
+        }
+    }
+    if (errors) {
+        return 1;
+    }
+    printf("All supported implementations match the scalar version\n");
+    if (verify_only) {
+        return 0;
+    }
+    fill_random(src, BUFFER_PIXELS);
+    fill_random(actual, BUFFER_PIXELS);
+    int run_lengths[] = {4, 16, 58, 256};
+    for (int r = 0; r < 4; r++) {
+        printf("\nRun length %d, ns per pixel\n", run_lengths[r]);
+        printf("%-7s", "");
+        for (int k = 0; k < KERNEL_MAX; k++) {
+            printf("  %9.9s", KERNEL_NAMES[k]);
+        }
+        printf("\n");
+        for (int i = 0; i < BLIT_IMPLEMENTATION_MAX; i++) {
+            if (blit_is_supported((blit_implementation) i)) {
+                benchmark((blit_implementation) i, run_lengths[r]);
+            }
+        }
+    }
+    return 0;
+}
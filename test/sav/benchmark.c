@@ -0,0 +1,197 @@
+#include "core/backtrace.h"
+#include "game/file.h"
+#include "game/game.h"
+#include "game/tick.h"
+#include "game/time.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define TICKS_PER_DAY 50
+
+typedef struct {
+    int count;
+    double total;
+    double max;
+} timing;
+
+static void handler(int sig)
+{
+    fprintf(stderr, "Oops, crashed with signal %d :(", sig);
+    backtrace_print();
+    exit(1);
+}
+
+static double now_ms(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static void add_timing(timing *t, double ms)
+{
+    t->count++;
+    t->total += ms;
+    if (ms > t->max) {
+        t->max = ms;
+    }
+}
+
+static void print_timing(const char *label, const timing *t)
+{
+    if (t->count) {
+        printf("  %-14s %7d  avg %9.4f ms  max %9.4f ms  total %10.2f ms\n",
+            label, t->count, t->total / t->count, t->max, t->total);
+    }
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static double percentile(const double *sorted, int count, int per_mille)
+{
+    int index = (int) (((long long) count * per_mille + 999) / 1000) - 1;
+    if (index < 0) {
+        index = 0;
+    }
+    return sorted[index];
+}
+
+static int run_benchmark(const char *saved_game, int ticks_to_run)
+{
+    if (!game_file_load_saved_game(saved_game)) {
+        printf("Unable to load saved game %s\n", saved_game);
+        return 0;
+    }
+    double *tick_times = (double *) malloc(ticks_to_run * sizeof(double));
+    if (!tick_times) {
+        printf("Out of memory\n");
+        return 0;
+    }
+    timing ticks = {0};
+    timing days = {0};
+    timing months = {0};
+    timing month_change_ticks = {0};
+    timing cases[TICKS_PER_DAY] = {{0}};
+
+    // days and months only count when they have been run from their start
+    double day_time = 0;
+    double month_time = 0;
+    int day_complete = 0;
+    int month_complete = 0;
+
+    for (int i = 0; i < ticks_to_run; i++) {
+        int tick = game_time_tick();
+        int month = game_time_month();
+        int day = game_time_day();
+        if (tick == 0) {
+            day_complete = 1;
+            if (day == 0) {
+                month_complete = 1;
+            }
+        }
+
+        double start = now_ms();
+        game_tick_run();
+        double elapsed = now_ms() - start;
+
+        tick_times[i] = elapsed;
+        add_timing(&ticks, elapsed);
+        if (tick >= 0 && tick < TICKS_PER_DAY) {
+            add_timing(&cases[tick], elapsed);
+        }
+        day_time += elapsed;
+        month_time += elapsed;
+        if (game_time_day() != day || game_time_month() != month) {
+            if (day_complete) {
+                add_timing(&days, day_time);
+            }
+            day_time = 0;
+            day_complete = 0;
+        }
+        if (game_time_month() != month) {
+            add_timing(&month_change_ticks, elapsed);
+            if (month_complete) {
+                add_timing(&months, month_time);
+            }
+            month_time = 0;
+            month_complete = 0;
+        }
+    }
+
+    qsort(tick_times, ticks_to_run, sizeof(double), compare_doubles);
+    printf("%s: %d ticks\n", saved_game, ticks_to_run);
+    print_timing("tick", &ticks);
+    print_timing("day", &days);
+    print_timing("month", &months);
+    print_timing("month change", &month_change_ticks);
+    printf("  tick latency   p50 %.4f ms  p90 %.4f ms  p99 %.4f ms  p99.9 %.4f ms\n",
+        percentile(tick_times, ticks_to_run, 500), percentile(tick_times, ticks_to_run, 900),
+        percentile(tick_times, ticks_to_run, 990), percentile(tick_times, ticks_to_run, 999));
+    // each case also includes the work done on every tick, such as figure actions
+    printf("  per advance_tick case:\n");
+    for (int i = 0; i < TICKS_PER_DAY; i++) {
+        char label[16];
+        snprintf(label, sizeof(label), "case %d", i);
+        print_timing(label, &cases[i]);
+    }
+    free(tick_times);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        printf("Usage: %s <ticks> <saved game> [<saved game> ...]\n", argv[0]);
+        return -1;
+    }
+    int ticks = atoi(argv[1]);
+    if (ticks <= 0) {
+        printf("Number of ticks must be positive\n");
+        return -1;
+    }
+    signal(SIGSEGV, handler);
+
+    if (!game_pre_init()) {
+        printf("Unable to run Game_preInit\n");
+        return 1;
+    }
+    if (!game_init()) {
+        printf("Unable to run Game_init\n");
+        return 2;
+    }
+    int result = 0;
+    double total = 0;
+    for (int i = 2; i < argc; i++) {
+        double start = now_ms();
+        if (!run_benchmark(argv[i], ticks)) {
+            result = 3;
+        }
+        total += now_ms() - start;
+    }
+    printf("Total: %.2f ms\n", total);
+    game_exit();
+    return result;
+}
@@ -0,0 +1,240 @@
+#include "building/building.h"
+#include "core/backtrace.h"
+#include "core/buffer.h"
+#include "core/config.h"
+#include "core/time.h"
+#include "figure/figure.h"
+#include "figure/route.h"
+#include "game/file.h"
+#include "game/game.h"
+#include "game/settings.h"
+#include "map/grid.h"
+#include "map/routing.h"
+#include "map/terrain.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define EXTRA_ENTITIES 100
+#define TICKS 500
+#define ROUTING_COUNTERS_SIZE 16
+
+typedef struct {
+    const char *filename;
+    int num_buildings;
+    int num_figures;
+    uint8_t routing_counters[ROUTING_COUNTERS_SIZE];
+} saved_game;
+
+static void handler(int sig)
+{
+    fprintf(stderr, "Oops, crashed with signal %d :(", sig);
+    backtrace_print();
+    exit(1);
+}
+
+static void run_ticks(int ticks)
+{
+    setting_reset_speeds(500, setting_scroll_speed());
+    time_set_millis(0);
+    for (int i = 1; i <= ticks; i++) {
+        time_set_millis(2 * i);
+        game_run();
+    }
+}
+
+static int files_equal(const char *file1, const char *file2)
+{
+    FILE *fp1 = fopen(file1, "rb");
+    FILE *fp2 = fopen(file2, "rb");
+    int equal = fp1 && fp2;
+    while (equal) {
+        int c1 = fgetc(fp1);
+        int c2 = fgetc(fp2);
+        equal = c1 == c2;
+        if (c1 == EOF) {
+            break;
+        }
+    }
+    if (fp1) {
+        fclose(fp1);
+    }
+    if (fp2) {
+        fclose(fp2);
+    }
+    if (!equal) {
+        printf("Files %s and %s differ\n", file1, file2);
+    }
+    return equal;
+}
+
+static void grow_entity_tables(void)
+{
+    config_set(CONFIG_GP_EXTEND_ENTITY_LIMITS, 1);
+    while (building_count() <= ORIGINAL_MAX_BUILDINGS + EXTRA_ENTITIES) {
+        if (!building_create(BUILDING_WELL, 10, 10)->id) {
+            break;
+        }
+    }
+    while (figure_count() <= ORIGINAL_MAX_FIGURES + EXTRA_ENTITIES) {
+        if (!figure_create(FIGURE_EXPLOSION, 10, 10, DIR_0_TOP)->id) {
+            break;
+        }
+    }
+}
+
+static int find_road_tiles(int *road_x, int *road_y, int *blocked_x, int *blocked_y)
+{
+    int found_road = 0;
+    int found_blocked = 0;
+    for (int y = 0; y < map_grid_height() && !(found_road && found_blocked); y++) {
+        for (int x = 0; x < map_grid_width() - 1; x++) {
+            int grid_offset = map_grid_offset(x, y);
+            if (!found_road && map_terrain_is(grid_offset, TERRAIN_ROAD) &&
+                map_terrain_is(grid_offset + 1, TERRAIN_ROAD)) {
+                *road_x = x;
+                *road_y = y;
+                found_road = 1;
+            } else if (!found_blocked && !map_terrain_is(grid_offset, TERRAIN_ROAD)) {
+                *blocked_x = x;
+                *blocked_y = y;
+                found_blocked = 1;
+            }
+        }
+    }
+    return found_road && found_blocked;
+}
+
+static figure *create_routed_figure(int x, int y, int destination_x, int destination_y)
+{
+    figure *f = figure_create(FIGURE_EXPLOSION, x, y, DIR_0_TOP);
+    if (f->id) {
+        f->terrain_usage = TERRAIN_USAGE_ROADS;
+        f->destination_x = destination_x;
+        f->destination_y = destination_y;
+        figure_route_add(f);
+    }
+    return f;
+}
+
+static int grow_route_table(void)
+{
+    int road_x, road_y, blocked_x, blocked_y;
+    if (!find_road_tiles(&road_x, &road_y, &blocked_x, &blocked_y)) {
+        printf("Unable to find road tiles for routes\n");
+        return 0;
+    }
+    while (figure_route_count() <= ORIGINAL_MAX_ROUTES) {
+        if (!create_routed_figure(road_x, road_y, road_x + 1, road_y)->routing_path_id) {
+            printf("Unable to grow the route table: %d routes\n", figure_route_count());
+            return 0;
+        }
+    }
+    // routes that cannot be found don't use up route slots
+    int num_routes = figure_route_count();
+    for (int i = 0; i < EXTRA_ENTITIES; i++) {
+        if (create_routed_figure(road_x, road_y, blocked_x, blocked_y)->routing_path_id) {
+            printf("Found a route to a tile without road\n");
+            return 0;
+        }
+    }
+    if (figure_route_count() != num_routes) {
+        printf("Failed routes changed the route table from %d to %d routes\n", num_routes, figure_route_count());
+        return 0;
+    }
+    return 1;
+}
+
+static void save_game(saved_game *game)
+{
+    buffer buf;
+    buffer_init(&buf, game->routing_counters, ROUTING_COUNTERS_SIZE);
+    map_routing_save_state(&buf);
+    game->num_buildings = building_count();
+    game->num_figures = figure_count();
+    game_file_write_saved_game(game->filename);
+}
+
+static int load_game(saved_game *game)
+{
+    // the city sounds are reset to the current time
+    time_set_millis(0);
+    if (!game_file_load_saved_game(game->filename)) {
+        printf("Unable to load saved game %s\n", game->filename);
+        return 0;
+    }
+    // loading calculates the distances to Rome, which counts as a route: undo that so the files can be compared
+    buffer buf;
+    buffer_init(&buf, game->routing_counters, ROUTING_COUNTERS_SIZE);
+    map_routing_load_state(&buf);
+
+    if (building_count() != game->num_buildings || figure_count() != game->num_figures) {
+        printf("Entity counts changed: %d buildings, %d figures, expected %d and %d\n",
+            building_count(), figure_count(), game->num_buildings, game->num_figures);
+        return 0;
+    }
+    return 1;
+}
+
+static int check_round_trip(saved_game *game, saved_game *reloaded)
+{
+    if (!load_game(game)) {
+        return 0;
+    }
+    save_game(reloaded);
+    return files_equal(game->filename, reloaded->filename);
+}
+
+static int run_test(const char *input_saved_game)
+{
+    printf("Saving and loading %s with extended entity limits\n", input_saved_game);
+    signal(SIGSEGV, handler);
+
+    if (!game_pre_init() || !game_init()) {
+        printf("Unable to initialize the game\n");
+        return 0;
+    }
+    if (!game_file_load_saved_game(input_saved_game)) {
+        printf("Unable to load saved game %s\n", input_saved_game);
+        return 0;
+    }
+    grow_entity_tables();
+    if (building_count() <= ORIGINAL_MAX_BUILDINGS || figure_count() <= ORIGINAL_MAX_FIGURES) {
+        printf("Unable to grow the entity tables: %d buildings, %d figures\n", building_count(), figure_count());
+        return 0;
+    }
+    if (!grow_route_table()) {
+        return 0;
+    }
+
+    // loading resets the city sounds, so the first saved game is only used to get a loaded game
+    saved_game start = {"limits-start.sav"};
+    saved_game loaded = {"limits-loaded.sav"};
+    saved_game reloaded = {"limits-reloaded.sav"};
+    save_game(&start);
+    if (!load_game(&start)) {
+        return 0;
+    }
+    save_game(&loaded);
+    if (!check_round_trip(&loaded, &reloaded)) {
+        return 0;
+    }
+
+    // the loaded game runs, and its routes and figures survive saving and loading too
+    saved_game after = {"limits-after.sav"};
+    saved_game after_reloaded = {"limits-after-reloaded.sav"};
+    run_ticks(TICKS);
+    save_game(&after);
+    // no game_exit(): it would save the changed configuration, which the other tests read
+    return check_round_trip(&after, &after_reloaded);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        printf("Usage: %s <saved game>\n", argv[0]);
+        return -1;
+    }
+    return run_test(argv[1]) ? 0 : 1;
+}
@@ -322,6 +322,42 @@ static int unpack(const char *filename, unsigned char *buffer)
     return offset;
 }
 
+int read_compressed_parts(const char *filename, compressed_part_callback callback, void *userdata)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        printf("Unable to open file %s\n", filename);
+        return 0;
+    }
+    int result = 1;
+    for (int i = 0; result && save_game_parts[i].length_in_bytes; i++) {
+        int length = save_game_parts[i].length_in_bytes;
+        if (!save_game_parts[i].compressed) {
+            result = fseek(fp, length, SEEK_CUR) == 0;
+            continue;
+        }
+        unsigned char intbuf[4];
+        if (fread(&intbuf, 1, 4, fp) != 4) {
+            result = 0;
+            break;
+        }
+        unsigned int input_size = to_uint(intbuf);
+        if (input_size == UNCOMPRESSED) {
+            result = fseek(fp, length, SEEK_CUR) == 0;
+        } else if (input_size > COMPRESS_BUFFER_SIZE
+            || fread(compress_buffer, 1, input_size, fp) != input_size) {
+            result = 0;
+        } else {
+            callback((const unsigned char *) compress_buffer, (int) input_size, length, userdata);
+        }
+    }
+    if (!result) {
+        printf("Error while reading file %s\n", filename);
+    }
+    fclose(fp);
+    return result;
+}
+
 static int has_adjacent_terrain_type(int part_offset, int terrain_type)
 {
     int grid_offset = part_offset / 2;
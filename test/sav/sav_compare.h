@@ -3,4 +3,15 @@
 
 int compare_files(const char *file1, const char *file2);
 
+typedef void (*compressed_part_callback)(const unsigned char *data, int size, int uncompressed_size, void *userdata);
+
+/**
+ * Calls the callback with the compressed data of every compressed part of a saved game
+ * @param filename Saved game
+ * @param callback Function to call for each part, parts stored uncompressed are skipped
+ * @param userdata Data to pass to the callback
+ * @return Boolean true if the whole file could be read
+ */
+int read_compressed_parts(const char *filename, compressed_part_callback callback, void *userdata);
+
 #endif // SAV_COMPARE_H
@@ -0,0 +1,258 @@
+#include "sav_compare.h"
+
+#include "../src/core/deflate.h"
+#include "../src/core/zip.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_ROUNDS 5
+#define DEFLATE_LEVEL 6
+#define STREAM_READ_SIZE 1000
+
+typedef struct {
+    unsigned char *compressed;
+    int compressed_size;
+    int size;
+    unsigned char *uncompressed;
+    unsigned char *deflated;
+    int deflated_size;
+} part;
+
+typedef struct {
+    const unsigned char *data;
+    int bytes_left;
+} memory_reader;
+
+static struct {
+    part *parts;
+    int num_parts;
+    int capacity;
+    int max_size;
+    int errors;
+} data;
+
+static double now_ms(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static void add_part(const unsigned char *compressed, int size, int uncompressed_size, void *userdata)
+{
+    if (data.num_parts >= data.capacity) {
+        data.capacity = data.capacity ? data.capacity * 2 : 64;
+        data.parts = (part *) realloc(data.parts, data.capacity * sizeof(part));
+        if (!data.parts) {
+            printf("Out of memory\n");
+            exit(1);
+        }
+    }
+    part *p = &data.parts[data.num_parts++];
+    p->compressed = (unsigned char *) malloc(size);
+    p->uncompressed = (unsigned char *) malloc(uncompressed_size);
+    if (!p->compressed || !p->uncompressed) {
+        printf("Out of memory\n");
+        exit(1);
+    }
+    memcpy(p->compressed, compressed, size);
+    p->compressed_size = size;
+    p->size = uncompressed_size;
+    if (uncompressed_size > data.max_size) {
+        data.max_size = uncompressed_size;
+    }
+}
+
+static int read_memory(void *buffer, int length, void *userdata)
+{
+    memory_reader *reader = (memory_reader *) userdata;
+    if (length > reader->bytes_left) {
+        length = reader->bytes_left;
+    }
+    memcpy(buffer, reader->data, length);
+    reader->data += length;
+    reader->bytes_left -= length;
+    return length;
+}
+
+static int read_memory_in_parts(void *buffer, int length, void *userdata)
+{
+    // odd sized reads, so the decoder has to refill its input in the middle of tokens
+    return read_memory(buffer, length > STREAM_READ_SIZE ? STREAM_READ_SIZE : length, userdata);
+}
+
+static int explode_part_stream(const part *p, unsigned char *buffer, int *size)
+{
+    memory_reader reader = { p->compressed, p->compressed_size };
+    return zip_decompress_stream(read_memory_in_parts, &reader, p->compressed_size, buffer, size);
+}
+
+static int inflate_part(const part *p, unsigned char *buffer, int *size)
+{
+    memory_reader reader = { p->deflated, p->deflated_size };
+    return deflate_decompress(read_memory, &reader, buffer, size);
+}
+
+static int deflate_part(part *p)
+{
+    int max_size = deflate_max_compressed_size(p->size);
+    p->deflated = (unsigned char *) malloc(max_size);
+    if (!p->deflated) {
+        printf("Out of memory\n");
+        exit(1);
+    }
+    p->deflated_size = max_size;
+    return deflate_compress(p->uncompressed, p->size, p->deflated, &p->deflated_size, DEFLATE_LEVEL);
+}
+
+static void verify(const char *filename, int first_part, unsigned char *buffer, int buffer_size)
+{
+    for (int i = first_part; i < data.num_parts; i++) {
+        part *p = &data.parts[i];
+        int size = p->size;
+        if (!zip_decompress(p->compressed, p->compressed_size, p->uncompressed, &size) || size != p->size) {
+            printf("%s: part %d does not decompress\n", filename, i - first_part);
+            data.errors++;
+            continue;
+        }
+        // the saves in test/data were written by Caesar 3 itself, which compresses exactly the same way
+        int compressed_size = buffer_size;
+        if (!zip_compress(p->uncompressed, p->size, buffer, &compressed_size)
+            || compressed_size != p->compressed_size || memcmp(buffer, p->compressed, compressed_size) != 0) {
+            printf("%s: part %d compresses differently (%d bytes instead of %d)\n",
+                filename, i - first_part, compressed_size, p->compressed_size);
+            data.errors++;
+        }
+        size = buffer_size;
+        if (!explode_part_stream(p, buffer, &size) || size != p->size || memcmp(buffer, p->uncompressed, size) != 0) {
+            printf("%s: part %d does not decompress as stream\n", filename, i - first_part);
+            data.errors++;
+        }
+        size = buffer_size;
+        if (!deflate_part(p) || !inflate_part(p, buffer, &size) || size != p->size
+            || memcmp(buffer, p->uncompressed, size) != 0) {
+            printf("%s: part %d does not survive deflate\n", filename, i - first_part);
+            data.errors++;
+        }
+    }
+}
+
+static void benchmark(unsigned char *buffer, int buffer_size)
+{
+    double total_size = 0;
+    double total_compressed = 0;
+    double total_deflated = 0;
+    for (int i = 0; i < data.num_parts; i++) {
+        total_size += data.parts[i].size;
+        total_compressed += data.parts[i].compressed_size;
+        total_deflated += data.parts[i].deflated_size;
+    }
+    printf("Compressed size: implode %.1f%%, deflate level %d %.1f%%\n",
+        total_compressed * 100 / total_size, DEFLATE_LEVEL, total_deflated * 100 / total_size);
+    total_size *= BENCHMARK_ROUNDS / (1024.0 * 1024.0);
+
+    double start = now_ms();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (int i = 0; i < data.num_parts; i++) {
+            int size = data.parts[i].size;
+            zip_decompress(data.parts[i].compressed, data.parts[i].compressed_size, buffer, &size);
+        }
+    }
+    double elapsed = now_ms() - start;
+    printf("Decompress: %10.2f ms  %8.2f MB/s\n", elapsed, total_size * 1000.0 / elapsed);
+
+    start = now_ms();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (int i = 0; i < data.num_parts; i++) {
+            int size = data.parts[i].size;
+            explode_part_stream(&data.parts[i], buffer, &size);
+        }
+    }
+    elapsed = now_ms() - start;
+    printf("Stream:     %10.2f ms  %8.2f MB/s\n", elapsed, total_size * 1000.0 / elapsed);
+
+    start = now_ms();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (int i = 0; i < data.num_parts; i++) {
+            int size = buffer_size;
+            zip_compress(data.parts[i].uncompressed, data.parts[i].size, buffer, &size);
+        }
+    }
+    elapsed = now_ms() - start;
+    printf("Compress:   %10.2f ms  %8.2f MB/s\n", elapsed, total_size * 1000.0 / elapsed);
+
+    start = now_ms();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (int i = 0; i < data.num_parts; i++) {
+            int size = data.parts[i].size;
+            inflate_part(&data.parts[i], buffer, &size);
+        }
+    }
+    elapsed = now_ms() - start;
+    printf("Inflate:    %10.2f ms  %8.2f MB/s\n", elapsed, total_size * 1000.0 / elapsed);
+
+    start = now_ms();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (int i = 0; i < data.num_parts; i++) {
+            int size = buffer_size;
+            deflate_compress(data.parts[i].uncompressed, data.parts[i].size, buffer, &size, DEFLATE_LEVEL);
+        }
+    }
+    elapsed = now_ms() - start;
+    printf("Deflate:    %10.2f ms  %8.2f MB/s\n", elapsed, total_size * 1000.0 / elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    int verify_only = argc > 1 && strcmp(argv[1], "--verify") == 0;
+    int first_file = verify_only ? 2 : 1;
+    if (first_file >= argc) {
+        printf("Usage: %s [--verify] FILE...\n", argv[0]);
+        return 1;
+    }
+    unsigned char *buffer = 0;
+    int buffer_size = 0;
+    for (int f = first_file; f < argc; f++) {
+        int first_part = data.num_parts;
+        if (!read_compressed_parts(argv[f], add_part, 0)) {
+            return 1;
+        }
+        if (data.max_size > buffer_size) {
+            // room for data that does not compress well
+            buffer_size = data.max_size * 2;
+            free(buffer);
+            buffer = (unsigned char *) malloc(buffer_size);
+            if (!buffer) {
+                printf("Out of memory\n");
+                return 1;
+            }
+        }
+        verify(argv[f], first_part, buffer, buffer_size);
+    }
+    if (data.errors) {
+        return 1;
+    }
+    printf("All %d compressed parts decompress and compress to the same data, also as stream and with deflate\n", data.num_parts);
+    if (!verify_only) {
+        benchmark(buffer, buffer_size);
+    }
+    return 0;
+}
@@ -53,6 +53,14 @@ int image_load_enemy(int enemy_id)
     return 1;
 }
 
+void image_set_external_cache_size(int max_bytes)
+{
+}
+
+void image_prefetch_group(int group)
+{
+}
+
 int image_group(int group)
 {
     return groups[group];
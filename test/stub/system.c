@@ -0,0 +1,21 @@
+#include "game/system.h"
+
+int system_task_thread_count(void)
+{
+    return 1;
+}
+
+void system_run_tasks(system_task task, int num_tasks, void *userdata)
+{
+    for (int i = 0; i < num_tasks; i++) {
+        task(i, userdata);
+    }
+}
+
+int system_start_background_task(system_task task, void *userdata)
+{
+    return 0;
+}
+
+void system_wait_for_background_task(void)
+{}